@@ -0,0 +1,288 @@
+// Connection-pool benchmark against a local stand-in server.
+// Starts a Unix-domain-socket echo server that delays every reply by a
+// configurable latency, then runs client threads that borrow a pooled
+// connection, do one request/response and return it. Runs once with a
+// fixed ResourcePool and once with an ElasticResourcePool, and reports
+// throughput, acquire wait percentiles and connection churn.
+//
+// Connections opened/closed count churn during the measured run only.
+//
+//   bazel run -c opt //bench:bench_connection_pool -- [threads=32] [pool=8]
+//       [latency_us=200] [seconds=3] [idle_ttl_ms=50]
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "elastic_resource_pool.hpp"
+#include "pool_metrics.hpp"
+#include "resource_pool.hpp"
+
+using namespace concurrency;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr size_t kMessageSize = 64;
+
+std::string g_socket_path;
+std::atomic<size_t> g_opened{0};
+std::atomic<size_t> g_closed{0};
+
+bool read_all(int fd, char *buffer, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::read(fd, buffer, size);
+        if (n <= 0) {
+            return false;
+        }
+        buffer += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool write_all(int fd, const char *buffer, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, buffer, size);
+        if (n <= 0) {
+            return false;
+        }
+        buffer += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+sockaddr_un socket_address() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, g_socket_path.c_str(),
+                 sizeof(address.sun_path) - 1);
+    return address;
+}
+
+// Echo server: one thread per connection, each reply delayed by `latency`
+class EchoServer {
+public:
+    explicit EchoServer(std::chrono::microseconds latency) : latency_(latency) {
+        ::unlink(g_socket_path.c_str());
+        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        auto address = socket_address();
+        if (listen_fd_ < 0 ||
+            ::bind(listen_fd_, reinterpret_cast<sockaddr *>(&address),
+                   sizeof(address)) != 0 ||
+            ::listen(listen_fd_, 1024) != 0) {
+            throw std::runtime_error("cannot listen on " + g_socket_path);
+        }
+        acceptor_ = std::thread(&EchoServer::accept_loop, this);
+    }
+
+    ~EchoServer() {
+        ::shutdown(listen_fd_, SHUT_RDWR);
+        ::close(listen_fd_);
+        acceptor_.join();
+        // Connection threads exit once their clients hang up
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &thread : connections_) {
+            thread.join();
+        }
+        ::unlink(g_socket_path.c_str());
+    }
+
+private:
+    std::chrono::microseconds latency_;
+    int listen_fd_ = -1;
+    std::thread acceptor_;
+    std::mutex mutex_;
+    std::vector<std::thread> connections_;
+
+    void accept_loop() {
+        while (true) {
+            int fd = ::accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                return;  // Listening socket shut down
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            connections_.emplace_back(&EchoServer::serve, this, fd);
+        }
+    }
+
+    void serve(int fd) {
+        std::array<char, kMessageSize> buffer;
+        while (read_all(fd, buffer.data(), buffer.size())) {
+            std::this_thread::sleep_for(latency_);
+            if (!write_all(fd, buffer.data(), buffer.size())) {
+                break;
+            }
+        }
+        ::close(fd);
+    }
+};
+
+// A client connection to the echo server; connects on construction
+struct EchoConnection {
+    int fd;
+
+    explicit EchoConnection(size_t = 0) : fd(::socket(AF_UNIX, SOCK_STREAM, 0)) {
+        auto address = socket_address();
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr *>(&address),
+                                sizeof(address)) != 0) {
+            throw std::runtime_error("cannot connect to " + g_socket_path);
+        }
+        g_opened.fetch_add(1);
+    }
+
+    ~EchoConnection() {
+        ::close(fd);
+        g_closed.fetch_add(1);
+    }
+
+    EchoConnection(const EchoConnection &) = delete;
+    EchoConnection &operator=(const EchoConnection &) = delete;
+
+    void round_trip() {
+        std::array<char, kMessageSize> request{};
+        std::array<char, kMessageSize> reply;
+        if (!write_all(fd, request.data(), request.size()) ||
+            !read_all(fd, reply.data(), reply.size())) {
+            throw std::runtime_error("echo round trip failed");
+        }
+    }
+};
+
+struct Config {
+    size_t threads = 32;
+    size_t pool = 8;
+    std::chrono::microseconds latency{200};
+    std::chrono::milliseconds duration{3000};
+    std::chrono::milliseconds idle_ttl{50};
+};
+
+struct Result {
+    size_t requests = 0;
+    LatencyHistogram::Snapshot wait;
+    size_t opened = 0;
+    size_t closed = 0;
+};
+
+// Each client: borrow, one round trip, return, then think for a random
+// 0..2x the server latency so load (and the elastic pool's size) varies
+template<typename Borrow>
+Result run_clients(const Config &config, Borrow borrow) {
+    LatencyHistogram wait;
+    std::atomic<size_t> requests{0};
+    std::atomic<bool> stop{false};
+    size_t opened = g_opened.load();
+    size_t closed = g_closed.load();
+
+    std::vector<std::thread> clients;
+    for (size_t t = 0; t < config.threads; ++t) {
+        clients.emplace_back([&, t]() {
+            std::minstd_rand rng(static_cast<unsigned>(t));
+            std::uniform_int_distribution<int64_t> think(0, 2 * config.latency.count());
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto start = Clock::now();
+                borrow([&](EchoConnection &connection) {
+                    wait.record(Clock::now() - start);
+                    connection.round_trip();
+                });
+                requests.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::sleep_for(std::chrono::microseconds(think(rng)));
+            }
+        });
+    }
+    std::this_thread::sleep_for(config.duration);
+    stop = true;
+    for (auto &client : clients) {
+        client.join();
+    }
+    return {requests.load(), wait.snapshot(), g_opened.load() - opened,
+            g_closed.load() - closed};
+}
+
+void report(const char *name, const Config &config, const Result &result) {
+    double seconds = std::chrono::duration<double>(config.duration).count();
+    auto us = [](std::chrono::nanoseconds ns) {
+        return std::chrono::duration<double, std::micro>(ns).count();
+    };
+    std::printf("%-8s %10.0f %12.1f %12.1f %10zu %10zu\n", name,
+                static_cast<double>(result.requests) / seconds,
+                us(result.wait.percentile(0.5)), us(result.wait.percentile(0.99)),
+                result.opened, result.closed);
+}
+
+Config parse(int argc, char **argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto eq = arg.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument("expected key=value, got " + arg);
+        }
+        std::string key = arg.substr(0, eq);
+        long value = std::strtol(arg.c_str() + eq + 1, nullptr, 10);
+        if (key == "threads") {
+            config.threads = static_cast<size_t>(value);
+        } else if (key == "pool") {
+            config.pool = static_cast<size_t>(value);
+        } else if (key == "latency_us") {
+            config.latency = std::chrono::microseconds(value);
+        } else if (key == "seconds") {
+            config.duration = std::chrono::seconds(value);
+        } else if (key == "idle_ttl_ms") {
+            config.idle_ttl = std::chrono::milliseconds(value);
+        } else {
+            throw std::invalid_argument("unknown option " + key);
+        }
+    }
+    return config;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Config config = parse(argc, argv);
+    g_socket_path = "/tmp/bench_connection_pool." + std::to_string(::getpid());
+    EchoServer server(config.latency);
+
+    std::printf("threads=%zu pool=%zu latency=%lldus duration=%lldms\n",
+                config.threads, config.pool,
+                static_cast<long long>(config.latency.count()),
+                static_cast<long long>(config.duration.count()));
+    std::printf("%-8s %10s %12s %12s %10s %10s\n", "pool", "req/s",
+                "p50 wait us", "p99 wait us", "opened", "closed");
+
+    {
+        ResourcePool<EchoConnection> pool(config.pool);
+        auto result = run_clients(config, [&](auto &&use) {
+            auto handle = pool.acquire_handle();
+            use(*handle);
+        });
+        report("fixed", config, result);
+    }
+    {
+        ElasticResourcePool<EchoConnection> pool(
+            []() { return std::make_shared<EchoConnection>(); },
+            std::max<size_t>(1, config.pool / 4), config.pool, config.idle_ttl);
+        auto result = run_clients(config, [&](auto &&use) {
+            auto handle = pool.acquire_handle();
+            use(*handle);
+        });
+        report("elastic", config, result);
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+// DiningPhilosophers fork strategies, each run for a fixed duration.
+// "busy": eats per second on rings of 5 to 64 philosophers with zero-length
+// meals, i.e. pure fork contention.
+// "short meals": throughput, p99 hunger time and fairness from 5 up to 10k
+// philosophers. Fairness is Jain's index over eat counts (1 = perfectly
+// even) and the min/max eat count ratio.
+// "simulated": the same figures from DiningSimulation, a million meals per
+// row in virtual time, up to 100k philosophers. The simulation is an
+// idealised-queue model: mutex forks go to waiters in FIFO order with no
+// barging and cross-word bitmask pairs are claimed in one step, so its
+// fairness is an upper bound on the threaded rows.
+//
+//   bazel run -c opt //bench:bench_dining_philosophers -- [milliseconds]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "dining_philosophers.hpp"
+#include "dining_simulation.hpp"
+
+using namespace concurrency;
+using std::chrono::microseconds;
+
+namespace {
+
+struct Result {
+    double eats_per_second;
+    double hunger_p99_us;
+    double jain_fairness;
+    double min_max_ratio;
+};
+
+Result run(int philosophers, ForkStrategyKind strategy, DiningPhilosophers::Timing timing,
+           std::chrono::milliseconds duration) {
+    DiningPhilosophers table(philosophers, strategy);
+    table.set_timing(timing);
+    auto start = std::chrono::steady_clock::now();
+    table.start_dining();
+    std::this_thread::sleep_for(duration);
+    table.stop_dining();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    auto counts = table.get_eat_counts();
+    double sum = 0;
+    double sum_squares = 0;
+    for (int count : counts) {
+        sum += count;
+        sum_squares += static_cast<double>(count) * count;
+    }
+    auto [min, max] = std::minmax_element(counts.begin(), counts.end());
+    auto p99 = table.hunger_times().percentile(0.99);
+    return {sum / elapsed.count(),
+            std::chrono::duration<double, std::micro>(p99).count(),
+            sum_squares > 0 ? sum * sum / (counts.size() * sum_squares) : 0.0,
+            *max > 0 ? static_cast<double>(*min) / *max : 0.0};
+}
+
+struct Contender {
+    const char *name;
+    ForkStrategyKind strategy;
+    // Largest ring to try. The bitmask wakes every waiter on a word per
+    // release and try-backoff keeps losers runnable; with thousands of
+    // threads per core either starves the rest of the machine.
+    int max_seats;
+};
+
+const Contender kContenders[] = {
+    {"ordering", ForkStrategyKind::ResourceOrdering, 10000},
+    {"bitmask", ForkStrategyKind::AtomicBitmask, 1000},
+    {"chandy-misra", ForkStrategyKind::ChandyMisra, 10000},
+    {"arbitrator", ForkStrategyKind::Arbitrator, 10000},
+    {"try-backoff", ForkStrategyKind::TryLockBackoff, 1000},
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::chrono::milliseconds duration(argc > 1 ? std::atoi(argv[1]) : 1000);
+    const DiningPhilosophers::Timing busy{microseconds(0), microseconds(0),
+                                          microseconds(0), microseconds(0)};
+    const DiningPhilosophers::Timing short_meals{microseconds(0), microseconds(100),
+                                                 microseconds(0), microseconds(50)};
+
+    std::printf("busy (eats/s)\n%6s", "seats");
+    for (const auto &contender : kContenders) {
+        std::printf(" %13s", contender.name);
+    }
+    std::printf("\n");
+    for (int philosophers : {5, 16, 64}) {
+        std::printf("%6d", philosophers);
+        for (const auto &contender : kContenders) {
+            std::printf(" %13.0f",
+                        run(philosophers, contender.strategy, busy, duration).eats_per_second);
+        }
+        std::printf("\n");
+    }
+
+    std::printf("\nshort meals\n%-14s %6s %12s %14s %8s %8s\n", "strategy", "seats",
+                "eats/s", "p99 hunger us", "jain", "min/max");
+    for (const auto &contender : kContenders) {
+        for (int philosophers : {5, 100, 1000, 10000}) {
+            if (philosophers > contender.max_seats) {
+                continue;
+            }
+            auto result = run(philosophers, contender.strategy, short_meals, duration);
+            std::printf("%-14s %6d %12.0f %14.0f %8.3f %8.3f\n", contender.name,
+                        philosophers, result.eats_per_second, result.hunger_p99_us,
+                        result.jain_fairness, result.min_max_ratio);
+            std::fflush(stdout);
+        }
+    }
+
+    std::printf("\nsimulated (short meals, 1M meals)\n%-14s %6s %12s %14s %8s %8s %8s\n",
+                "strategy", "seats", "eats/s", "p99 hunger us", "jain", "min/max",
+                "wall ms");
+    for (const auto &contender : kContenders) {
+        for (int philosophers : {5, 1000, 100000}) {
+            auto start = std::chrono::steady_clock::now();
+            DiningSimulation simulation(philosophers, contender.strategy, short_meals);
+            auto result = simulation.run(1'000'000);
+            std::chrono::duration<double, std::milli> wall =
+                std::chrono::steady_clock::now() - start;
+            auto [min, max] =
+                std::minmax_element(result.eat_counts.begin(), result.eat_counts.end());
+            std::printf("%-14s %6d %12.0f %14.0f %8.3f %8.3f %8.0f\n", contender.name,
+                        philosophers,
+                        result.meals / std::chrono::duration<double>(result.virtual_time).count(),
+                        std::chrono::duration<double, std::micro>(
+                            result.hunger.percentile(0.99)).count(),
+                        result.jain_fairness(),
+                        *max > 0 ? static_cast<double>(*min) / *max : 0.0, wall.count());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+// Allocation-heavy workloads run once on the default pmr resource
+// (new/delete), once on std::pmr::synchronized_pool_resource and once on
+// SlabMemoryResource. Prints nanoseconds per operation.
+//
+//   bazel run -c opt //bench:bench_slab_memory_resource -- [threads]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+#include "slab_memory_resource.hpp"
+#include "thread_safe_cache.hpp"
+#include "thread_safe_queue.hpp"
+
+using namespace concurrency;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Node {
+    char payload[48];
+};
+
+// Run `body(thread_index)` on `threads` threads; ns per op over all of them
+double run(size_t threads, size_t ops_per_thread,
+           const std::function<void(size_t)> &body) {
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back(body, t);
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+    return elapsed.count() / static_cast<double>(threads * ops_per_thread);
+}
+
+// Each thread keeps a window of live nodes and replaces one per op
+double churn(std::pmr::memory_resource *resource, size_t threads, size_t ops) {
+    return run(threads, ops, [&](size_t) {
+        std::pmr::polymorphic_allocator<Node> alloc(resource);
+        std::vector<Node *> window(256, nullptr);
+        for (size_t i = 0; i < ops; ++i) {
+            Node *&slot = window[i % window.size()];
+            if (slot) {
+                alloc.deallocate(slot, 1);
+            }
+            slot = alloc.allocate(1);
+            slot->payload[0] = static_cast<char>(i);
+        }
+        for (Node *node : window) {
+            if (node) {
+                alloc.deallocate(node, 1);
+            }
+        }
+    });
+}
+
+// Half the threads push strings, half pop them: every allocation is freed
+// on another thread
+double queue_handoff(std::pmr::memory_resource *resource, size_t threads,
+                     size_t ops) {
+    size_t pairs = std::max<size_t>(1, threads / 2);
+    pmr::ThreadSafeQueue<std::pmr::string> queue(resource);
+    return run(pairs * 2, ops, [&](size_t t) {
+        if (t % 2 == 0) {
+            for (size_t i = 0; i < ops; ++i) {
+                // Long enough to defeat the small-string buffer
+                queue.push(std::pmr::string(40, 'x', resource));
+            }
+        } else {
+            for (size_t i = 0; i < ops; ++i) {
+                queue.wait_and_pop();
+            }
+        }
+    });
+}
+
+// LRU cache under insert/evict pressure
+double cache_churn(std::pmr::memory_resource *resource, size_t threads,
+                   size_t ops) {
+    pmr::ThreadSafeCache<size_t, size_t> cache(1024, resource);
+    return run(threads, ops, [&](size_t t) {
+        for (size_t i = 0; i < ops; ++i) {
+            cache.put(t * ops + i, i);
+        }
+    });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                              : std::max(2u, std::thread::hardware_concurrency());
+    constexpr size_t kOps = 200000;
+
+    struct Workload {
+        const char *name;
+        double (*fn)(std::pmr::memory_resource *, size_t, size_t);
+    };
+    const Workload workloads[] = {
+        {"churn", churn},
+        {"queue_handoff", queue_handoff},
+        {"cache_churn", cache_churn},
+    };
+
+    std::printf("threads=%zu ops/thread=%zu (ns/op)\n", threads, kOps);
+    std::printf("%-16s %12s %12s %12s\n", "workload", "new_delete",
+                "sync_pool", "slab");
+    for (const auto &workload : workloads) {
+        double baseline = workload.fn(std::pmr::new_delete_resource(), threads, kOps);
+        double pooled;
+        {
+            std::pmr::synchronized_pool_resource pool;
+            pooled = workload.fn(&pool, threads, kOps);
+        }
+        double slab;
+        {
+            SlabMemoryResource resource;
+            slab = workload.fn(&resource, threads, kOps);
+        }
+        std::printf("%-16s %12.1f %12.1f %12.1f\n", workload.name, baseline,
+                    pooled, slab);
+    }
+    return 0;
+}
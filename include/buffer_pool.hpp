@@ -0,0 +1,320 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <semaphore>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+#include "lock_free_index_stack.hpp"
+
+namespace concurrency {
+
+namespace detail {
+
+// One power-of-two size class: `count` buffers of `buffer_size` bytes,
+// carved from the pool's arena, with a refcount per buffer
+struct BufferClass {
+    BufferClass(std::byte *base, size_t buffer_size, size_t count)
+        : base(base), buffer_size(buffer_size), count(count),
+          refs(std::make_unique<std::atomic<uint32_t>[]>(count)), free(count),
+          available(static_cast<std::ptrdiff_t>(count)) {
+        for (size_t i = count; i-- > 0;) {
+            free.push(static_cast<uint32_t>(i));
+        }
+    }
+
+    std::byte *buffer(uint32_t index) const { return base + index * buffer_size; }
+
+    // Last reference gone: back on the free stack
+    void release(uint32_t index) {
+        free.push(index);
+        in_use.fetch_sub(1);
+        available.release();
+    }
+
+    std::byte *base;
+    size_t buffer_size;
+    size_t count;
+    std::unique_ptr<std::atomic<uint32_t>[]> refs;
+    LockFreeIndexStack free;
+    std::counting_semaphore<> available;
+    std::atomic<size_t> in_use{0};
+};
+
+} // namespace detail
+
+/**
+ * Refcounted view of part of a pooled buffer. Copying a slice or taking a
+ * sub-slice shares the buffer (one atomic increment, no data copy); the
+ * buffer returns to its BufferPool when the last slice referring to it is
+ * destroyed. Slices can be moved or copied through ThreadSafeQueue or
+ * ProducerConsumer like any value. Must not outlive the pool.
+ */
+class BufferSlice {
+public:
+    BufferSlice() = default;
+    ~BufferSlice() { reset(); }
+
+    BufferSlice(const BufferSlice &other) noexcept
+        : class_(other.class_), index_(other.index_), offset_(other.offset_),
+          length_(other.length_) {
+        retain();
+    }
+
+    BufferSlice(BufferSlice &&other) noexcept
+        : class_(std::exchange(other.class_, nullptr)), index_(other.index_),
+          offset_(other.offset_), length_(std::exchange(other.length_, 0)) {}
+
+    BufferSlice &operator=(BufferSlice other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    void swap(BufferSlice &other) noexcept {
+        std::swap(class_, other.class_);
+        std::swap(index_, other.index_);
+        std::swap(offset_, other.offset_);
+        std::swap(length_, other.length_);
+    }
+
+    std::byte *data() const {
+        return class_ ? class_->buffer(index_) + offset_ : nullptr;
+    }
+    size_t size() const { return length_; }
+    bool empty() const { return length_ == 0; }
+    std::span<std::byte> bytes() const { return {data(), length_}; }
+    explicit operator bool() const { return class_ != nullptr; }
+
+    /**
+     * Size of the whole underlying buffer
+     */
+    size_t capacity() const { return class_ ? class_->buffer_size : 0; }
+
+    /**
+     * Slices sharing this buffer, including this one
+     */
+    size_t use_count() const {
+        return class_ ? class_->refs[index_].load(std::memory_order_relaxed) : 0;
+    }
+
+    /**
+     * View of [offset, offset + length) of this slice, sharing the buffer.
+     * Throws std::out_of_range if it would extend past this slice.
+     */
+    BufferSlice slice(size_t offset, size_t length) const {
+        if (offset > length_ || length > length_ - offset) {
+            throw std::out_of_range("BufferSlice::slice out of range");
+        }
+        BufferSlice result(*this);
+        result.offset_ += offset;
+        result.length_ = length;
+        return result;
+    }
+
+    void reset() {
+        if (class_) {
+            if (class_->refs[index_].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                class_->release(index_);
+            }
+            class_ = nullptr;
+            length_ = 0;
+        }
+    }
+
+private:
+    friend class BufferPool;
+    BufferSlice(detail::BufferClass *buffer_class, uint32_t index, size_t length)
+        : class_(buffer_class), index_(index), length_(length) {
+        class_->refs[index_].store(1, std::memory_order_relaxed);
+    }
+
+    void retain() {
+        if (class_) {
+            class_->refs[index_].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    detail::BufferClass *class_ = nullptr;
+    uint32_t index_ = 0;
+    size_t offset_ = 0;
+    size_t length_ = 0;
+};
+
+/**
+ * Pool of I/O buffers in power-of-two size classes from `min_buffer` to
+ * `max_buffer`, `buffers_per_class` of each.
+ * All buffers live in one arena mapped and pre-faulted up front. On Linux
+ * the arena is 2 MiB aligned and advised MADV_HUGEPAGE, so hot buffers
+ * are covered by few TLB entries. Free buffers of a class sit on a
+ * lock-free index stack, so acquire and release take no lock.
+ */
+class BufferPool {
+public:
+    static constexpr size_t kHugePageSize = size_t{2} << 20;
+    static constexpr size_t kPageSize = 4096;
+
+    explicit BufferPool(size_t min_buffer = 4096, size_t max_buffer = 64 * 1024,
+                        size_t buffers_per_class = 32)
+        : min_buffer_(min_buffer), max_buffer_(max_buffer),
+          arena_(arena_size(min_buffer, max_buffer, buffers_per_class)) {
+        std::byte *next = arena_.base;
+        for (size_t size = min_buffer; size <= max_buffer; size *= 2) {
+            classes_.push_back(
+                std::make_unique<detail::BufferClass>(next, size, buffers_per_class));
+            next += size * buffers_per_class;
+        }
+    }
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    /**
+     * Slice of `size` bytes over a buffer of the smallest class that fits,
+     * waiting if that class is exhausted (blocking). Throws
+     * std::invalid_argument if size exceeds max_buffer.
+     */
+    BufferSlice acquire(size_t size) {
+        auto &buffer_class = class_for(size);
+        buffer_class.available.acquire();
+        return take(buffer_class, size);
+    }
+
+    /**
+     * Like acquire(), but returns an empty slice instead of waiting
+     */
+    BufferSlice try_acquire(size_t size) {
+        auto &buffer_class = class_for(size);
+        if (!buffer_class.available.try_acquire()) {
+            return BufferSlice();
+        }
+        return take(buffer_class, size);
+    }
+
+    // Statistics
+    size_t num_classes() const { return classes_.size(); }
+    size_t class_size(size_t size_class) const {
+        return classes_.at(size_class)->buffer_size;
+    }
+    size_t available(size_t size_class) const {
+        const auto &buffer_class = *classes_.at(size_class);
+        return buffer_class.count - buffer_class.in_use.load();
+    }
+    size_t in_use() const {
+        size_t total = 0;
+        for (const auto &buffer_class : classes_) {
+            total += buffer_class->in_use.load();
+        }
+        return total;
+    }
+    size_t arena_bytes() const { return arena_.bytes; }
+    /**
+     * Whether the kernel accepted the MADV_HUGEPAGE advice. Advice only:
+     * whether huge pages actually back the arena is up to the kernel
+     * (see AnonHugePages in /proc/self/smaps).
+     */
+    bool huge_pages_requested() const { return arena_.huge_pages_requested; }
+
+private:
+    static constexpr size_t round_up(size_t n, size_t to) {
+        return (n + to - 1) / to * to;
+    }
+
+    // The mapped, pre-faulted buffer memory. A member of its own, built
+    // before the size classes, so it is unmapped even if they throw.
+    struct Arena {
+        std::byte *base = nullptr;
+        size_t bytes = 0;
+        bool huge_pages_requested = false;
+#ifdef __linux__
+        void *mapping = nullptr;
+        size_t mapping_bytes = 0;
+#endif
+
+        explicit Arena(size_t size) {
+#ifdef __linux__
+            // Over-map by one huge page so the arena can start on a 2 MiB
+            // boundary, which transparent huge pages need
+            bytes = round_up(size, kHugePageSize);
+            mapping_bytes = bytes + kHugePageSize;
+            mapping = mmap(nullptr, mapping_bytes, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapping == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            auto start = reinterpret_cast<uintptr_t>(mapping);
+            base = reinterpret_cast<std::byte *>(round_up(start, kHugePageSize));
+            huge_pages_requested = madvise(base, bytes, MADV_HUGEPAGE) == 0;
+#else
+            bytes = round_up(size, kPageSize);
+            base = static_cast<std::byte *>(
+                ::operator new(bytes, std::align_val_t{kPageSize}));
+#endif
+            // Pre-fault so the first use of a buffer doesn't page-fault
+            for (size_t offset = 0; offset < bytes; offset += kPageSize) {
+                base[offset] = std::byte{0};
+            }
+        }
+
+        ~Arena() {
+#ifdef __linux__
+            munmap(mapping, mapping_bytes);
+#else
+            ::operator delete(base, std::align_val_t{kPageSize});
+#endif
+        }
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+    };
+
+    size_t min_buffer_;
+    size_t max_buffer_;
+    Arena arena_;
+    std::vector<std::unique_ptr<detail::BufferClass>> classes_;
+
+    // Bytes for every class; throws before anything is mapped
+    static size_t arena_size(size_t min_buffer, size_t max_buffer,
+                             size_t buffers_per_class) {
+        if (!std::has_single_bit(min_buffer) || !std::has_single_bit(max_buffer) ||
+            min_buffer > max_buffer || buffers_per_class == 0 ||
+            buffers_per_class > UINT32_MAX - 1) {
+            throw std::invalid_argument("BufferPool needs power-of-two "
+                                        "min_buffer <= max_buffer and "
+                                        "buffers_per_class > 0");
+        }
+        size_t total = 0;
+        for (size_t size = min_buffer; size <= max_buffer; size *= 2) {
+            total += size * buffers_per_class;
+        }
+        return total;
+    }
+
+    detail::BufferClass &class_for(size_t size) {
+        if (size > max_buffer_) {
+            throw std::invalid_argument("BufferPool request exceeds max_buffer");
+        }
+        size_t rounded = std::bit_ceil(std::max(size, min_buffer_));
+        return *classes_[std::countr_zero(rounded) - std::countr_zero(min_buffer_)];
+    }
+
+    // Caller holds a permit, so the stack has (or is about to get) an index
+    static BufferSlice take(detail::BufferClass &buffer_class, size_t size) {
+        uint32_t index;
+        while ((index = buffer_class.free.pop()) == LockFreeIndexStack::npos) {
+            std::this_thread::yield();
+        }
+        buffer_class.in_use.fetch_add(1);
+        return BufferSlice(&buffer_class, index, size);
+    }
+};
+
+} // namespace concurrency
@@ -0,0 +1,270 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include "coroutine_scheduler.hpp"
+
+namespace concurrency {
+
+/**
+ * Bounded channel for coroutines.
+ * `co_await push(item)` suspends while the channel is full and
+ * `co_await pop()` suspends while it is empty. A suspended side is completed
+ * directly by its counterpart: push hands its item straight to the oldest
+ * waiting consumer and resumes it on the pushing thread, and pop moves the
+ * oldest waiting producer's item into the freed slot and requeues that
+ * producer on the scheduler.
+ */
+template<typename T>
+class AsyncChannel {
+public:
+    AsyncChannel(size_t capacity, CoroutineScheduler &scheduler)
+        : capacity_(capacity), scheduler_(scheduler) {
+        if (capacity_ == 0) {
+            throw std::invalid_argument("AsyncChannel capacity must be > 0");
+        }
+    }
+
+    AsyncChannel(const AsyncChannel &) = delete;
+    AsyncChannel &operator=(const AsyncChannel &) = delete;
+
+    class PushAwaiter {
+    public:
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) {
+            return channel_.suspend_push(*this, handle);
+        }
+        // False if the channel was closed and the item was not accepted
+        bool await_resume() const noexcept { return accepted_; }
+
+    private:
+        friend class AsyncChannel;
+        PushAwaiter(AsyncChannel &channel, T item)
+            : channel_(channel), item_(std::move(item)) {}
+
+        AsyncChannel &channel_;
+        T item_;
+        std::coroutine_handle<> handle_;
+        bool accepted_{false};
+    };
+
+    class PopAwaiter {
+    public:
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> handle) {
+            return channel_.suspend_pop(*this, handle);
+        }
+        // nullopt once the channel is closed and drained
+        std::optional<T> await_resume() { return std::move(item_); }
+
+    private:
+        friend class AsyncChannel;
+        explicit PopAwaiter(AsyncChannel &channel) : channel_(channel) {}
+
+        AsyncChannel &channel_;
+        std::optional<T> item_;
+        std::coroutine_handle<> handle_;
+    };
+
+    PushAwaiter push(T item) { return PushAwaiter(*this, std::move(item)); }
+    PopAwaiter pop() { return PopAwaiter(*this); }
+
+    /**
+     * Reject further pushes and wake every waiter. Consumers still drain
+     * the items already buffered.
+     */
+    void close() {
+        std::deque<PushAwaiter *> producers;
+        std::deque<PopAwaiter *> consumers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            producers.swap(push_waiters_);
+            consumers.swap(pop_waiters_);
+        }
+        for (auto *producer : producers) {
+            scheduler_.post(producer->handle_);
+        }
+        for (auto *consumer : consumers) {
+            scheduler_.post(consumer->handle_);
+        }
+    }
+
+    /**
+     * Accept pushes again after close()
+     */
+    void reopen() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = false;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return buffer_.size();
+    }
+
+private:
+    size_t capacity_;
+    CoroutineScheduler &scheduler_;
+    mutable std::mutex mutex_;
+    std::deque<T> buffer_;
+    // Producers only wait while buffer_ is full, consumers only while empty
+    std::deque<PushAwaiter *> push_waiters_;
+    std::deque<PopAwaiter *> pop_waiters_;
+    bool closed_{false};
+
+    // Returning `handle` resumes the caller immediately,
+    // std::noop_coroutine() leaves it suspended.
+    std::coroutine_handle<> suspend_push(PushAwaiter &self,
+                                         std::coroutine_handle<> handle) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (closed_) {
+            return handle;
+        }
+        self.accepted_ = true;
+        if (!pop_waiters_.empty()) {
+            PopAwaiter *consumer = pop_waiters_.front();
+            pop_waiters_.pop_front();
+            consumer->item_.emplace(std::move(self.item_));
+            lock.unlock();
+            // Run the consumer on this thread; the producer continues on the
+            // pool. `self` may be gone once posted.
+            auto consumer_handle = consumer->handle_;
+            scheduler_.post(handle);
+            return consumer_handle;
+        }
+        if (buffer_.size() < capacity_) {
+            buffer_.push_back(std::move(self.item_));
+            return handle;
+        }
+        self.accepted_ = false;
+        self.handle_ = handle;
+        push_waiters_.push_back(&self);
+        return std::noop_coroutine();
+    }
+
+    std::coroutine_handle<> suspend_pop(PopAwaiter &self,
+                                        std::coroutine_handle<> handle) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!buffer_.empty()) {
+            self.item_.emplace(std::move(buffer_.front()));
+            buffer_.pop_front();
+            if (!push_waiters_.empty()) {
+                PushAwaiter *producer = push_waiters_.front();
+                push_waiters_.pop_front();
+                buffer_.push_back(std::move(producer->item_));
+                producer->accepted_ = true;
+                lock.unlock();
+                scheduler_.post(producer->handle_);
+            }
+            return handle;
+        }
+        if (closed_) {
+            return handle;
+        }
+        self.handle_ = handle;
+        pop_waiters_.push_back(&self);
+        return std::noop_coroutine();
+    }
+};
+
+/**
+ * Producer-Consumer where producers and consumers are coroutines
+ * multiplexed on a fixed worker pool instead of one std::thread each.
+ * A full or empty buffer suspends the coroutine rather than blocking its
+ * worker thread. producer_func and consumer_func themselves still run on
+ * (and may block) a worker thread.
+ */
+template<typename T>
+class CoroutineProducerConsumer {
+public:
+    explicit CoroutineProducerConsumer(
+        size_t buffer_size,
+        size_t num_workers = std::thread::hardware_concurrency())
+        : scheduler_(num_workers), channel_(buffer_size, scheduler_) {}
+
+    ~CoroutineProducerConsumer() { stop(); }
+
+    /**
+     * Start the given number of producer and consumer coroutines
+     */
+    void start(int num_producers, int num_consumers,
+               std::function<T()> producer_func,
+               std::function<void(T)> consumer_func) {
+        channel_.reopen();
+        running_.store(true);
+        active_tasks_.fetch_add(num_producers + num_consumers);
+        for (int i = 0; i < num_producers; i++) {
+            producer_task(producer_func);
+        }
+        for (int i = 0; i < num_consumers; i++) {
+            consumer_task(consumer_func);
+        }
+    }
+
+    /**
+     * Stop producing, let consumers drain the buffer and wait for every
+     * coroutine to finish.
+     */
+    void stop() {
+        running_ = false;
+        channel_.close();
+        size_t active = active_tasks_.load();
+        while (active != 0) {
+            active_tasks_.wait(active);
+            active = active_tasks_.load();
+        }
+    }
+
+    /**
+     * Get statistics
+     */
+    size_t items_produced() const { return items_produced_.load(); }
+    size_t items_consumed() const { return items_consumed_.load(); }
+    size_t current_buffer_size() const { return channel_.size(); }
+    size_t num_workers() const { return scheduler_.num_threads(); }
+
+private:
+    CoroutineScheduler scheduler_;
+    AsyncChannel<T> channel_;
+
+    // Statistics
+    std::atomic<size_t> items_produced_{0};
+    std::atomic<size_t> items_consumed_{0};
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> active_tasks_{0};
+
+    DetachedTask producer_task(std::function<T()> producer_func) {
+        co_await scheduler_.schedule();
+        while (running_.load()) {
+            auto item = producer_func();
+            if (!co_await channel_.push(std::move(item))) {
+                break;  // Closed by stop()
+            }
+            items_produced_.fetch_add(1);
+        }
+        task_finished();
+    }
+
+    DetachedTask consumer_task(std::function<void(T)> consumer_func) {
+        co_await scheduler_.schedule();
+        while (auto item = co_await channel_.pop()) {
+            items_consumed_.fetch_add(1);
+            consumer_func(std::move(*item));
+        }
+        task_finished();
+    }
+
+    void task_finished() {
+        if (active_tasks_.fetch_sub(1) == 1) {
+            active_tasks_.notify_all();
+        }
+    }
+};
+
+} // namespace concurrency
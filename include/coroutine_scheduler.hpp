@@ -0,0 +1,115 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace concurrency {
+
+/**
+ * Fixed pool of worker threads that resumes ready coroutines in FIFO order.
+ * Lets many logical tasks share a few OS threads.
+ */
+class CoroutineScheduler {
+public:
+    explicit CoroutineScheduler(size_t num_threads) {
+        num_threads = std::max<size_t>(num_threads, 1);
+        workers_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            workers_.emplace_back(&CoroutineScheduler::worker_loop, this);
+        }
+    }
+
+    ~CoroutineScheduler() { shutdown(); }
+
+    /**
+     * Runs every coroutine that is ready, including ones they post while
+     * draining, then joins the workers. Safe to call more than once.
+     */
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        ready_cv_.notify_all();
+        for (auto &worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    CoroutineScheduler(const CoroutineScheduler &) = delete;
+    CoroutineScheduler &operator=(const CoroutineScheduler &) = delete;
+
+    /**
+     * Queue a suspended coroutine to be resumed on a worker thread.
+     */
+    void post(std::coroutine_handle<> handle) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.push_back(handle);
+        }
+        ready_cv_.notify_one();
+    }
+
+    /**
+     * `co_await scheduler.schedule()` moves the caller onto the pool.
+     */
+    auto schedule() {
+        struct ScheduleAwaiter {
+            CoroutineScheduler &scheduler;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                scheduler.post(handle);
+            }
+            void await_resume() const noexcept {}
+        };
+        return ScheduleAwaiter{*this};
+    }
+
+    size_t num_threads() const { return workers_.size(); }
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::mutex mutex_;
+    std::condition_variable ready_cv_;
+    bool stopping_{false};
+
+    void worker_loop() {
+        while (true) {
+            std::coroutine_handle<> handle;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_cv_.wait(lock,
+                               [this]() { return stopping_ || !ready_.empty(); });
+                if (ready_.empty()) {
+                    return;
+                }
+                handle = ready_.front();
+                ready_.pop_front();
+            }
+            handle.resume();
+        }
+    }
+};
+
+/**
+ * Fire-and-forget coroutine. Starts eagerly and frees itself on completion.
+ */
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+} // namespace concurrency
@@ -2,8 +2,12 @@
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <string>
 #include <vector>
 #include <chrono>
+#include <memory>
+#include "fork_strategies.hpp"
+#include "pool_metrics.hpp"
 
 namespace concurrency {
 
@@ -13,46 +17,83 @@ namespace concurrency {
  */
 class DiningPhilosophers {
 public:
-    explicit DiningPhilosophers(int num_philosophers = 5);
+    using Strategy = ForkStrategyKind;
+    using State = PhilosopherState;
+
+    /**
+     * Random think and eat durations, drawn uniformly from [min, max]
+     */
+    struct Timing {
+        std::chrono::microseconds think_min{10'000};
+        std::chrono::microseconds think_max{100'000};
+        std::chrono::microseconds eat_min{10'000};
+        std::chrono::microseconds eat_max{50'000};
+    };
+
+    explicit DiningPhilosophers(int num_philosophers = 5,
+                                Strategy strategy = Strategy::ResourceOrdering);
+    /**
+     * Use a custom strategy built for the same number of philosophers
+     */
+    explicit DiningPhilosophers(std::unique_ptr<ForkStrategy> strategy);
     ~DiningPhilosophers();
-    enum class State { Think = 0, WaitLeft, WaitRight, Eat };
+
+    /**
+     * Change think and eat durations; call before start_dining()
+     */
+    void set_timing(Timing timing);
+
     /**
      * Start the dining session. Each philosopher should:
      * 1. Think for a random time
      * 2. Try to pick up both forks
-     * 3. Eat for a random time  
+     * 3. Eat for a random time
      * 4. Put down both forks
      * 5. Repeat until stopped
      */
     void start_dining();
-    
+
     /**
      * Stop all philosophers
      */
     void stop_dining();
-    
+
     /**
      * Get statistics about how many times each philosopher has eaten
      */
     std::vector<int> get_eat_counts() const;
-    
+
     /**
-     * Check if any deadlock has been detected
+     * Whether philosophers at this table are stuck in a lock cycle, per
+     * LockMonitor's wait-for graph. The built-in strategies cannot
+     * deadlock, so this only turns true for a custom strategy that blocks
+     * on its MonitoredMutex forks in a cycle, such as left then right.
      */
     bool is_deadlocked() const;
 
+    /**
+     * Distribution of time from getting hungry to starting to eat
+     */
+    LatencyHistogram::Snapshot hunger_times() const { return hunger_.snapshot(); }
+
+    ForkStrategy &fork_strategy() const { return *strategy_; }
+
 private:
     int num_philosophers_;
+    std::unique_ptr<ForkStrategy> strategy_;
+    Timing timing_;
     std::atomic<bool> running_{false};
-    std::vector<std::mutex> forks_;
+    // Held shut until every thread exists, so large rings don't spend
+    // start-up competing with the thread creating them
+    std::atomic<bool> start_gate_{false};
+    LatencyHistogram hunger_;
     std::vector<std::thread> threads_;
     std::mutex output_mutex_;
     std::vector<std::atomic<int>> eat_counts_;
     std::vector<std::atomic<State>> states_;
 
-    // TODO: Implement proper fork management and deadlock prevention
     void philosopher_routine(int philosopher_id);
     void output(int id, std::string const &msg);
 };
 
-} // namespace concurrency
\ No newline at end of file
+} // namespace concurrency
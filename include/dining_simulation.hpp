@@ -0,0 +1,137 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <queue>
+#include <random>
+#include <vector>
+#include "dining_philosophers.hpp"
+#include "fork_strategies.hpp"
+#include "pool_metrics.hpp"
+
+namespace concurrency {
+
+/**
+ * Outcome of a DiningSimulation run, cumulative over all runs so far
+ */
+struct SimulationResult {
+    uint64_t meals{0};
+    std::chrono::nanoseconds virtual_time{0};
+    std::vector<uint64_t> eat_counts;
+    LatencyHistogram::Snapshot hunger;  // Hungry to eating, in virtual time
+    // The event queue ran dry with someone still hungry
+    bool deadlocked{false};
+
+    /**
+     * Jain's fairness index over eat counts: 1 when everyone ate equally,
+     * 1/n when one philosopher ate everything
+     */
+    double jain_fairness() const;
+};
+
+/**
+ * Dining philosophers in virtual time. Philosophers are state machines
+ * driven by a priority queue of timed events on a single thread; think
+ * and eat times advance a virtual clock instead of sleeping, so a million
+ * meals take well under a second and a given seed always produces the
+ * same run.
+ * Each strategy kind is modelled by its fork hand-off rules: mutexes as FIFO
+ * queues, the bitmask as all-or-nothing claims retried on every release,
+ * Chandy-Misra with instant messages, the arbitrator as a FIFO of n - 1
+ * seats and try-lock with the same jittered doubling backoff.
+ *
+ * This is an idealised-queue model, not a replay of the threaded code. A
+ * released std::mutex is not handed to its oldest waiter: whichever thread
+ * gets there first takes it, and a waiter can lose to a barging neighbour
+ * again and again. The bitmask model also claims pairs that span two words
+ * in one step, where AtomicBitmaskForks takes them one fork at a time.
+ * Fairness figures are therefore an upper bound on what the threaded
+ * strategies achieve; compare strategies with it, not absolute numbers.
+ */
+class DiningSimulation {
+public:
+    using Timing = DiningPhilosophers::Timing;
+
+    DiningSimulation(int num_philosophers, ForkStrategyKind strategy, Timing timing = {},
+                     uint64_t seed = 1);
+
+    /**
+     * Advance until `meals` more meals have finished, or nothing can move
+     */
+    SimulationResult run(uint64_t meals);
+
+private:
+    enum class Phase { Thinking, Hungry, BackingOff, Eating };
+    enum class EventKind { Hungry, DoneEating, Retry };
+
+    struct Event {
+        std::chrono::nanoseconds at;
+        uint64_t seq;  // Ties go to the earlier scheduled event
+        int philosopher;
+        EventKind kind;
+        bool operator>(const Event &other) const {
+            return at != other.at ? at > other.at : seq > other.seq;
+        }
+    };
+
+    struct Philosopher {
+        Phase phase = Phase::Thinking;
+        std::chrono::nanoseconds hungry_since{0};
+        std::chrono::nanoseconds backoff{0};
+        uint64_t meals = 0;
+        bool seated = false;  // Arbitrator
+        // AtomicBitmask: registered as a watcher of the left/right fork
+        bool watching_left = false;
+        bool watching_right = false;
+    };
+
+    // Chandy-Misra fork state, as in ChandyMisraForks
+    struct ChandyMisraFork {
+        int owner = 0;
+        bool dirty = true;
+        bool in_use = false;
+        bool requested = false;
+    };
+
+    int num_philosophers_;
+    ForkStrategyKind strategy_;
+    Timing timing_;
+    std::mt19937_64 gen_;
+    std::chrono::nanoseconds now_{0};
+    uint64_t next_seq_{0};
+    uint64_t meals_{0};
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+    std::vector<Philosopher> philosophers_;
+    // -1 when free. Mutex-style strategies hand a released fork straight to
+    // the first waiter.
+    std::vector<int> holders_;
+    std::vector<std::deque<int>> waiters_;
+    std::vector<ChandyMisraFork> cm_forks_;
+    int free_seats_{0};
+    std::deque<int> seat_waiters_;
+    // Philosophers whose situation changed and must try again
+    std::vector<int> wake_;
+    LatencyHistogram hunger_;
+
+    int left_fork(int id) const { return id; }
+    int right_fork(int id) const { return (id + 1) % num_philosophers_; }
+    std::chrono::nanoseconds draw(std::chrono::microseconds min,
+                                  std::chrono::microseconds max);
+    void schedule(std::chrono::nanoseconds delay, int philosopher, EventKind kind);
+    void handle(const Event &event);
+    void advance(int id);
+    void start_eating(int id);
+    void finish_eating(int id);
+
+    bool lock_in_order(int id, int first, int second);
+    void release_fork(int fork);
+    void advance_bitmask(int id);
+    void release_bitmask(int fork);
+    void advance_chandy_misra(int id);
+    void cm_request(int id, int fork);
+    void cm_send(int fork, int to);
+    int neighbour_across(int fork, int id) const;
+    void advance_try_lock(int id);
+};
+
+} // namespace concurrency
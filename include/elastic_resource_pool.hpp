@@ -0,0 +1,301 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "resource_pool.hpp"
+
+namespace concurrency {
+
+/**
+ * Resource pool that grows and shrinks between `min_size` and `max_size`.
+ * Resources come from a factory: `min_size` of them are created up front
+ * (in parallel), the rest lazily when an acquirer finds no idle resource.
+ * A background reaper destroys resources that stayed idle longer than
+ * `idle_ttl`, never going below `min_size`.
+ *
+ * The semaphore counts the right to hold a resource (max_size permits),
+ * not existing resources, so eviction never touches it. Idle resources
+ * are reused LIFO, which keeps the cold ones at the front for the reaper.
+ */
+template<typename Resource>
+class ElasticResourcePool {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Factory = std::function<std::shared_ptr<Resource>()>;
+
+    ElasticResourcePool(Factory factory, size_t min_size, size_t max_size,
+                        Clock::duration idle_ttl = std::chrono::seconds(60))
+        : factory_(std::move(factory)), min_size_(min_size),
+          max_size_(max_size), idle_ttl_(idle_ttl), permits_(max_size) {
+        if (max_size_ == 0 || min_size_ > max_size_) {
+            throw std::invalid_argument("ElasticResourcePool needs "
+                                        "0 <= min_size <= max_size, max_size > 0");
+        }
+        warm_up();
+        reaper_ = std::thread(&ElasticResourcePool::reaper_loop, this);
+    }
+
+    ~ElasticResourcePool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        reaper_cv_.notify_all();
+        reaper_.join();
+    }
+
+    ElasticResourcePool(const ElasticResourcePool &) = delete;
+    ElasticResourcePool &operator=(const ElasticResourcePool &) = delete;
+
+    /**
+     * Move-only RAII handle; returns the resource to the pool on destruction
+     */
+    class Handle {
+    public:
+        Handle() = default;
+        ~Handle() { reset(); }
+
+        Handle(const Handle &) = delete;
+        Handle &operator=(const Handle &) = delete;
+
+        Handle(Handle &&other) noexcept
+            : pool_(std::exchange(other.pool_, nullptr)),
+              resource_(std::move(other.resource_)) {}
+
+        Handle &operator=(Handle &&other) noexcept {
+            if (this != &other) {
+                reset();
+                pool_ = std::exchange(other.pool_, nullptr);
+                resource_ = std::move(other.resource_);
+            }
+            return *this;
+        }
+
+        Resource *get() const { return resource_.get(); }
+        Resource *operator->() const { return get(); }
+        Resource &operator*() const { return *resource_; }
+        explicit operator bool() const { return resource_ != nullptr; }
+
+        void reset() {
+            if (resource_) {
+                std::exchange(pool_, nullptr)->release(std::move(resource_));
+            }
+        }
+
+    private:
+        friend class ElasticResourcePool;
+        Handle(ElasticResourcePool *pool, std::shared_ptr<Resource> resource)
+            : pool_(pool), resource_(std::move(resource)) {}
+
+        ElasticResourcePool *pool_ = nullptr;
+        std::shared_ptr<Resource> resource_;
+    };
+
+    /**
+     * Acquire a resource, creating one if none is idle (blocking)
+     */
+    std::shared_ptr<Resource> acquire() {
+        permits_.acquire();
+        return take_or_create();
+    }
+
+    /**
+     * Try to acquire a resource with timeout. Returns nullptr on timeout.
+     */
+    std::shared_ptr<Resource> try_acquire(std::chrono::milliseconds timeout) {
+        if (!permits_.try_acquire_for(timeout)) {
+            return nullptr;
+        }
+        return take_or_create();
+    }
+
+    Handle acquire_handle() { return Handle(this, acquire()); }
+
+    Handle try_acquire_handle(std::chrono::milliseconds timeout) {
+        auto resource = try_acquire(timeout);
+        return resource ? Handle(this, std::move(resource)) : Handle();
+    }
+
+    /**
+     * Return a resource to the idle set. Throws std::invalid_argument if
+     * this pool didn't create it.
+     */
+    void release(std::shared_ptr<Resource> resource) {
+        if (!resource) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!created_.contains(resource.get())) {
+                throw std::invalid_argument("Resource does not belong to this pool");
+            }
+            idle_.push_back({std::move(resource), Clock::now()});
+        }
+        in_use_.fetch_sub(1);
+        permits_.release();
+    }
+
+    // Statistics
+    size_t size() const { return alive_.load(); }  // Idle + in use
+    size_t idle_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return idle_.size();
+    }
+    size_t current_usage() const { return in_use_.load(); }
+    size_t peak_usage() const { return peak_usage_.load(); }
+    size_t total_created() const { return total_created_.load(); }
+    size_t total_evicted() const { return total_evicted_.load(); }
+    size_t min_size() const { return min_size_; }
+    size_t max_size() const { return max_size_; }
+
+private:
+    struct IdleEntry {
+        std::shared_ptr<Resource> resource;
+        Clock::time_point idle_since;
+    };
+
+    Factory factory_;
+    size_t min_size_;
+    size_t max_size_;
+    Clock::duration idle_ttl_;
+    std::counting_semaphore<> permits_;
+
+    std::deque<IdleEntry> idle_;  // Oldest idle at the front
+    std::unordered_set<const Resource *> created_;  // Alive, idle or in use
+    mutable std::mutex mutex_;
+    std::condition_variable reaper_cv_;
+    std::thread reaper_;
+    bool stopping_{false};
+
+    // Statistics
+    std::atomic<size_t> alive_{0};
+    std::atomic<size_t> in_use_{0};
+    std::atomic<size_t> peak_usage_{0};
+    std::atomic<size_t> total_created_{0};
+    std::atomic<size_t> total_evicted_{0};
+
+    // Caller holds a permit
+    std::shared_ptr<Resource> take_or_create() {
+        std::shared_ptr<Resource> resource;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty()) {
+                resource = std::move(idle_.back().resource);
+                idle_.pop_back();
+            }
+        }
+        if (!resource) {
+            alive_.fetch_add(1);
+            try {
+                resource = create();
+            } catch (...) {
+                alive_.fetch_sub(1);
+                permits_.release();
+                throw;
+            }
+        }
+
+        size_t usage = in_use_.fetch_add(1) + 1;
+        size_t peak = peak_usage_.load();
+        while (usage > peak && !peak_usage_.compare_exchange_weak(peak, usage)) {
+        }
+        return resource;
+    }
+
+    std::shared_ptr<Resource> create() {
+        auto resource = factory_();
+        if (!resource) {
+            throw std::runtime_error("ElasticResourcePool factory returned null");
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            created_.insert(resource.get());
+        }
+        total_created_.fetch_add(1);
+        return resource;
+    }
+
+    // Create the first min_size resources on parallel threads. Creation is
+    // usually latency-bound (connect, handshake), so use at least 8 threads
+    // even on small machines.
+    void warm_up() {
+        if (min_size_ == 0) {
+            return;
+        }
+        size_t num_threads = std::min<size_t>(
+            std::max(std::thread::hardware_concurrency(), 8u), min_size_);
+        std::atomic<size_t> next{0};
+        std::exception_ptr error;
+        std::vector<std::thread> threads;
+        auto join_all = [&]() {
+            for (auto &thread : threads) {
+                thread.join();
+            }
+        };
+        try {
+            for (size_t t = 0; t < num_threads; ++t) {
+                threads.emplace_back([&]() {
+                    while (next.fetch_add(1) < min_size_) {
+                        try {
+                            auto resource = create();
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            idle_.push_back({std::move(resource), Clock::now()});
+                            alive_.fetch_add(1);
+                        } catch (...) {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            if (!error) {
+                                error = std::current_exception();
+                            }
+                        }
+                    }
+                });
+            }
+        } catch (...) {
+            // Couldn't start a thread: stop the others before giving up
+            next.store(min_size_);
+            join_all();
+            throw;
+        }
+        join_all();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void reaper_loop() {
+        auto period = std::max<Clock::duration>(idle_ttl_ / 2,
+                                                std::chrono::milliseconds(1));
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!reaper_cv_.wait_for(lock, period, [this]() { return stopping_; })) {
+            std::vector<std::shared_ptr<Resource>> evicted;
+            auto cutoff = Clock::now() - idle_ttl_;
+            while (!idle_.empty() && idle_.front().idle_since <= cutoff &&
+                   alive_.load() > min_size_) {
+                created_.erase(idle_.front().resource.get());
+                evicted.push_back(std::move(idle_.front().resource));
+                idle_.pop_front();
+                alive_.fetch_sub(1);
+            }
+            if (evicted.empty()) {
+                continue;
+            }
+            // Tear-down (closing connections etc.) runs outside the lock
+            lock.unlock();
+            total_evicted_.fetch_add(evicted.size());
+            evicted.clear();
+            lock.lock();
+        }
+    }
+};
+
+} // namespace concurrency
@@ -0,0 +1,173 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <vector>
+#include "lock_monitor.hpp"
+
+namespace concurrency {
+
+/**
+ * What a philosopher is doing, as reported by DiningPhilosophers
+ */
+enum class PhilosopherState { Think = 0, WaitLeft, WaitRight, Eat };
+
+/**
+ * How philosophers around one table share forks. Philosopher i uses forks
+ * i (left) and (i + 1) % n (right). pick_up() blocks until the caller
+ * holds both; it may move `state` from WaitLeft to WaitRight once it holds
+ * one. Implement this to plug a new strategy into DiningPhilosophers.
+ */
+class ForkStrategy {
+public:
+    explicit ForkStrategy(int num_philosophers) : num_philosophers_(num_philosophers) {}
+    virtual ~ForkStrategy() = default;
+
+    ForkStrategy(const ForkStrategy &) = delete;
+    ForkStrategy &operator=(const ForkStrategy &) = delete;
+
+    virtual void pick_up(int philosopher_id, std::atomic<PhilosopherState> &state) = 0;
+    virtual void put_down(int philosopher_id) = 0;
+    virtual const char *name() const = 0;
+
+    /**
+     * Whether `lock` is one of this table's MonitoredMutex forks, so
+     * LockMonitor reports can be attributed to it
+     */
+    virtual bool uses_lock(const void *) const { return false; }
+
+    int num_philosophers() const { return num_philosophers_; }
+
+protected:
+    int left_fork(int philosopher_id) const { return philosopher_id; }
+    int right_fork(int philosopher_id) const {
+        return (philosopher_id + 1) % num_philosophers_;
+    }
+    template<typename T>
+    static bool within(const std::vector<T> &items, const void *p) {
+        std::less<const void *> less;
+        return !items.empty() && !less(p, items.data()) && less(p, items.data() + items.size());
+    }
+
+    int num_philosophers_;
+};
+
+/**
+ * The built-in strategies
+ */
+enum class ForkStrategyKind {
+    // One mutex per fork, locked lower index first. This and the other
+    // mutex-based strategies report to LockMonitor.
+    ResourceOrdering,
+    // Forks are bits of atomic words (32 per word). A pair within one word
+    // is claimed with one CAS, never holding one fork while waiting for the
+    // other; a pair spanning two words (every 32nd seat and the wrap-around)
+    // is claimed fork by fork in word order, which cannot form a cycle
+    AtomicBitmask,
+    // Chandy-Misra: each fork belongs to one neighbour and is clean or
+    // dirty; a hungry philosopher sends request tokens for the forks it
+    // lacks, and a dirty fork not in use is always handed over. Only the
+    // two neighbours of a fork ever touch it, and nobody waits for more
+    // than its neighbours' meals.
+    ChandyMisra,
+    // A waiter seats at most n - 1 philosophers, so one of them always
+    // gets both forks
+    Arbitrator,
+    // Lock the left fork, try the right; on failure drop both and back off
+    // for a random, growing time
+    TryLockBackoff,
+};
+
+std::unique_ptr<ForkStrategy> make_fork_strategy(ForkStrategyKind strategy, int num_philosophers);
+
+class ResourceOrderingForks : public ForkStrategy {
+public:
+    explicit ResourceOrderingForks(int num_philosophers);
+    void pick_up(int philosopher_id, std::atomic<PhilosopherState> &state) override;
+    void put_down(int philosopher_id) override;
+    const char *name() const override { return "ordering"; }
+    bool uses_lock(const void *lock) const override { return within(forks_, lock); }
+
+private:
+    std::vector<MonitoredMutex<>> forks_;
+};
+
+class AtomicBitmaskForks : public ForkStrategy {
+public:
+    explicit AtomicBitmaskForks(int num_philosophers);
+    void pick_up(int philosopher_id, std::atomic<PhilosopherState> &state) override;
+    void put_down(int philosopher_id) override;
+    const char *name() const override { return "bitmask"; }
+
+private:
+    // Bit f % 32 of word f / 32 is set while fork f is taken. 32-bit words
+    // are futex sized, so atomic::wait sleeps on the word itself rather
+    // than on a hashed proxy shared with other words, which on large rings
+    // woke hundreds of unrelated waiters per release.
+    static constexpr int kForksPerWord = 32;
+    std::vector<std::atomic<uint32_t>> words_;
+
+    static int word_of(int fork) { return fork / kForksPerWord; }
+    static uint32_t bit_of(int fork) { return uint32_t{1} << fork % kForksPerWord; }
+    void claim(int word, uint32_t mask);
+    void release(int word, uint32_t mask);
+};
+
+class ChandyMisraForks : public ForkStrategy {
+public:
+    explicit ChandyMisraForks(int num_philosophers);
+    void pick_up(int philosopher_id, std::atomic<PhilosopherState> &state) override;
+    void put_down(int philosopher_id) override;
+    const char *name() const override { return "chandy-misra"; }
+
+private:
+    // Fork f lies between philosophers f - 1 and f
+    struct alignas(64) SharedFork {
+        std::mutex mutex;
+        int owner = 0;
+        bool dirty = true;
+        bool in_use = false;     // Owner is eating with it
+        bool requested = false;  // The other neighbour holds the request token
+    };
+    std::vector<SharedFork> forks_;
+    // Bumped whenever a fork reaches or leaves the philosopher
+    std::vector<std::atomic<uint32_t>> inboxes_;
+
+    void request(int philosopher_id, int fork);
+    bool try_start_eating(int philosopher_id);
+    void send(SharedFork &fork, int to);
+    int neighbour_across(int fork, int philosopher_id) const;
+};
+
+class ArbitratorForks : public ForkStrategy {
+public:
+    explicit ArbitratorForks(int num_philosophers);
+    void pick_up(int philosopher_id, std::atomic<PhilosopherState> &state) override;
+    void put_down(int philosopher_id) override;
+    const char *name() const override { return "arbitrator"; }
+    bool uses_lock(const void *lock) const override { return within(forks_, lock); }
+
+private:
+    std::counting_semaphore<> seats_;
+    std::vector<MonitoredMutex<>> forks_;
+};
+
+class TryLockBackoffForks : public ForkStrategy {
+public:
+    static constexpr int64_t kMinBackoffNs = 1'000;
+    static constexpr int64_t kMaxBackoffNs = 1'000'000;
+
+    explicit TryLockBackoffForks(int num_philosophers);
+    void pick_up(int philosopher_id, std::atomic<PhilosopherState> &state) override;
+    void put_down(int philosopher_id) override;
+    const char *name() const override { return "try-backoff"; }
+    bool uses_lock(const void *lock) const override { return within(forks_, lock); }
+
+private:
+    std::vector<MonitoredMutex<>> forks_;
+};
+
+} // namespace concurrency
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace concurrency {
+
+/**
+ * Bounded lock-free stack of slot indices in [0, capacity) (Treiber stack).
+ * Links live in a side array indexed by slot, so push and pop never
+ * allocate. The head packs a 32-bit index with a 32-bit tag that changes
+ * on every update, which defeats ABA when an index is popped and pushed
+ * back between another thread's load and CAS.
+ * Each index may be in the stack at most once.
+ */
+class LockFreeIndexStack {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    explicit LockFreeIndexStack(size_t capacity)
+        : next_(std::make_unique<std::atomic<uint32_t>[]>(capacity)) {}
+
+    LockFreeIndexStack(const LockFreeIndexStack &) = delete;
+    LockFreeIndexStack &operator=(const LockFreeIndexStack &) = delete;
+
+    void push(uint32_t index) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        do {
+            next_[index].store(index_of(head), std::memory_order_relaxed);
+        } while (!head_.compare_exchange_weak(head,
+                                              pack(index, tag_of(head) + 1),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    /**
+     * Pop the most recently pushed index, or npos if the stack is empty
+     */
+    uint32_t pop() {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        while (index_of(head) != npos) {
+            // May read a stale link if head was recycled; the tag makes
+            // the CAS below fail in that case
+            uint32_t next = next_[index_of(head)].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, pack(next, tag_of(head) + 1),
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                return index_of(head);
+            }
+        }
+        return npos;
+    }
+
+    bool empty() const {
+        return index_of(head_.load(std::memory_order_relaxed)) == npos;
+    }
+
+private:
+    std::unique_ptr<std::atomic<uint32_t>[]> next_;
+    std::atomic<uint64_t> head_{pack(npos, 0)};
+
+    static constexpr uint64_t pack(uint32_t index, uint32_t tag) {
+        return (static_cast<uint64_t>(tag) << 32) | index;
+    }
+    static constexpr uint32_t index_of(uint64_t head) {
+        return static_cast<uint32_t>(head);
+    }
+    static constexpr uint32_t tag_of(uint64_t head) {
+        return static_cast<uint32_t>(head >> 32);
+    }
+};
+
+} // namespace concurrency
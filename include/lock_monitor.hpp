@@ -0,0 +1,512 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace concurrency {
+
+/**
+ * A thread blocked on a lock, as seen by LockMonitor
+ */
+struct LockWait {
+    uint64_t thread;  // LockMonitor's number for the thread, not the OS id
+    const void *lock;
+    std::chrono::nanoseconds waited;
+};
+
+/**
+ * Result of one LockMonitor scan
+ */
+struct LockReport {
+    // In each cycle, cycle[i] waits for a lock held by cycle[i + 1] and the
+    // last waits for one held by the first
+    std::vector<std::vector<LockWait>> cycles;
+    // Waiting longer than the scan's starvation threshold
+    std::vector<LockWait> starved;
+
+    bool deadlocked() const { return !cycles.empty(); }
+    bool empty() const { return cycles.empty() && starved.empty(); }
+};
+
+/**
+ * Process-wide wait-for graph of MonitoredMutex locks.
+ * Every thread that touches a monitored lock gets a record it alone
+ * writes: the locks it holds and the one it is blocked on. Recording is a
+ * few atomic stores to that record, with no shared lock. scan() reads all
+ * records, builds the graph (waiter -> holders of the awaited lock) and
+ * reports cycles and long waits. Records are read while their threads
+ * run, so a cycle is only reported if every thread in it is still in the
+ * same wait on a second pass; such a cycle is a real deadlock. Timed waits
+ * (try_lock_for, try_lock_until) give up on their own: they can starve
+ * but never close a cycle.
+ * An optional sampler thread scans periodically.
+ */
+class LockMonitor {
+public:
+    static constexpr size_t kMaxHeld = 16;  // Per thread; more are not tracked
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * One thread's locks. Only the owning thread writes it. `epoch_` is
+     * odd while the thread waits, like a seqlock around the wait.
+     */
+    class alignas(64) ThreadRecord {
+    public:
+        void begin_wait(const void *lock, bool timed = false) {
+            uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+            waiting_since_.store(Clock::now().time_since_epoch().count(),
+                                 std::memory_order_relaxed);
+            waiting_for_.store(lock, std::memory_order_relaxed);
+            waiting_timed_.store(timed, std::memory_order_relaxed);
+            epoch_.store(epoch + 1, std::memory_order_release);
+        }
+
+        void end_wait() {
+            epoch_.store(epoch_.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            waiting_for_.store(nullptr, std::memory_order_relaxed);
+        }
+
+        void acquired(const void *lock) {
+            uint32_t count = held_count_.load(std::memory_order_relaxed);
+            if (count < kMaxHeld) {
+                held_[count].store(lock, std::memory_order_relaxed);
+                held_count_.store(count + 1, std::memory_order_release);
+            }
+        }
+
+        void released(const void *lock) {
+            uint32_t count = held_count_.load(std::memory_order_relaxed);
+            for (uint32_t i = count; i-- > 0;) {
+                if (held_[i].load(std::memory_order_relaxed) == lock) {
+                    held_[i].store(held_[count - 1].load(std::memory_order_relaxed),
+                                   std::memory_order_relaxed);
+                    held_count_.store(count - 1, std::memory_order_release);
+                    return;
+                }
+            }
+        }
+
+        uint64_t thread_number() const { return thread_.load(std::memory_order_relaxed); }
+
+    private:
+        friend class LockMonitor;
+        std::atomic<bool> claimed_{false};
+        std::atomic<uint64_t> thread_{0};
+        std::atomic<uint64_t> epoch_{0};
+        std::atomic<const void *> waiting_for_{nullptr};
+        std::atomic<bool> waiting_timed_{false};
+        std::atomic<Clock::rep> waiting_since_{0};
+        std::atomic<uint32_t> held_count_{0};
+        std::array<std::atomic<const void *>, kMaxHeld> held_{};
+        ThreadRecord *next_{nullptr};  // Fixed once published
+    };
+
+    /**
+     * Records a wait for as long as it is in scope. A `timed` wait has a
+     * deadline, so it is never part of a deadlock.
+     */
+    class WaitScope {
+    public:
+        explicit WaitScope(const void *lock, bool timed = false) : record_(this_thread()) {
+            record_.begin_wait(lock, timed);
+        }
+        ~WaitScope() { record_.end_wait(); }
+        WaitScope(const WaitScope &) = delete;
+        WaitScope &operator=(const WaitScope &) = delete;
+
+    private:
+        ThreadRecord &record_;
+    };
+
+    /**
+     * The monitor all MonitoredMutex instances report to. Never destroyed,
+     * so threads may outlive main(); stop the sampler before exiting.
+     */
+    static LockMonitor &global() {
+        static LockMonitor *monitor = new LockMonitor();
+        return *monitor;
+    }
+
+    /**
+     * The calling thread's record, claimed on first use and given back
+     * when the thread exits
+     */
+    static ThreadRecord &this_thread() {
+        thread_local Registration registration(global());
+        return *registration.record;
+    }
+
+    /**
+     * One pass over all threads: confirmed wait cycles, and waits longer
+     * than `starvation_threshold`
+     */
+    LockReport scan(std::chrono::nanoseconds starvation_threshold = std::chrono::seconds(1)) const {
+        LockReport report;
+        auto now = Clock::now().time_since_epoch();
+        auto first = snapshot();
+        for (const auto &thread : first) {
+            if (thread.waiting_for && now - thread.since > starvation_threshold) {
+                report.starved.push_back(
+                    {thread.thread, thread.waiting_for, now - thread.since});
+            }
+        }
+
+        auto cycles = find_cycles(first);
+        if (cycles.empty()) {
+            return report;
+        }
+        std::unordered_map<uint64_t, const ThreadSnapshot *> second;
+        auto again = snapshot();
+        for (const auto &thread : again) {
+            second.emplace(thread.thread, &thread);
+        }
+        for (const auto &cycle : cycles) {
+            bool confirmed = std::all_of(cycle.begin(), cycle.end(), [&](size_t i) {
+                auto it = second.find(first[i].thread);
+                return it != second.end() && it->second->epoch == first[i].epoch;
+            });
+            if (confirmed) {
+                auto &waits = report.cycles.emplace_back();
+                for (size_t i : cycle) {
+                    waits.push_back({first[i].thread, first[i].waiting_for,
+                                     now - first[i].since});
+                }
+            }
+        }
+        return report;
+    }
+
+    /**
+     * Scan every `interval` on a background thread. `on_report`, if set,
+     * runs on that thread for each non-empty report.
+     */
+    void start_sampler(std::chrono::milliseconds interval,
+                       std::chrono::nanoseconds starvation_threshold,
+                       std::function<void(const LockReport &)> on_report = {}) {
+        stop_sampler();
+        std::lock_guard<std::mutex> lock(sampler_mutex_);
+        sampling_ = true;
+        sampler_ = std::thread([this, interval, starvation_threshold,
+                                on_report = std::move(on_report)]() {
+            std::unique_lock<std::mutex> lock(sampler_mutex_);
+            while (!sampler_cv_.wait_for(lock, interval, [this]() { return !sampling_; })) {
+                lock.unlock();
+                LockReport report = scan(starvation_threshold);
+                if (!report.empty() && on_report) {
+                    on_report(report);
+                }
+                lock.lock();
+                last_report_ = std::move(report);
+                ++samples_;
+            }
+        });
+    }
+
+    void stop_sampler() {
+        std::thread sampler;
+        {
+            std::lock_guard<std::mutex> lock(sampler_mutex_);
+            sampling_ = false;
+            sampler = std::move(sampler_);
+        }
+        sampler_cv_.notify_all();
+        if (sampler.joinable()) {
+            sampler.join();
+        }
+    }
+
+    LockReport last_report() const {
+        std::lock_guard<std::mutex> lock(sampler_mutex_);
+        return last_report_;
+    }
+
+    uint64_t samples() const {
+        std::lock_guard<std::mutex> lock(sampler_mutex_);
+        return samples_;
+    }
+
+private:
+    struct ThreadSnapshot {
+        uint64_t thread;
+        uint64_t epoch;
+        const void *waiting_for;  // Null unless caught consistently mid-wait
+        bool timed;
+        Clock::duration since;
+        std::vector<const void *> held;
+    };
+
+    struct Registration {
+        explicit Registration(LockMonitor &monitor) : monitor(monitor), record(monitor.claim()) {}
+        ~Registration() { monitor.unclaim(*record); }
+        LockMonitor &monitor;
+        ThreadRecord *record;
+    };
+
+    std::atomic<ThreadRecord *> records_{nullptr};
+    std::atomic<uint64_t> next_thread_{1};
+    mutable std::mutex sampler_mutex_;
+    std::condition_variable sampler_cv_;
+    std::thread sampler_;
+    bool sampling_{false};
+    LockReport last_report_;
+    uint64_t samples_{0};
+
+    LockMonitor() = default;
+
+    // Reuse a record left by an exited thread, else publish a new one
+    ThreadRecord *claim() {
+        ThreadRecord *record = records_.load(std::memory_order_acquire);
+        for (; record; record = record->next_) {
+            bool expected = false;
+            if (record->claimed_.compare_exchange_strong(expected, true)) {
+                break;
+            }
+        }
+        if (!record) {
+            record = new ThreadRecord();
+            record->claimed_.store(true, std::memory_order_relaxed);
+            record->next_ = records_.load(std::memory_order_relaxed);
+            while (!records_.compare_exchange_weak(record->next_, record,
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed)) {
+            }
+        }
+        record->thread_.store(next_thread_.fetch_add(1), std::memory_order_relaxed);
+        return record;
+    }
+
+    void unclaim(ThreadRecord &record) {
+        record.held_count_.store(0, std::memory_order_relaxed);
+        record.claimed_.store(false, std::memory_order_release);
+    }
+
+    std::vector<ThreadSnapshot> snapshot() const {
+        std::vector<ThreadSnapshot> threads;
+        for (auto *record = records_.load(std::memory_order_acquire); record;
+             record = record->next_) {
+            if (!record->claimed_.load(std::memory_order_acquire)) {
+                continue;
+            }
+            ThreadSnapshot thread;
+            thread.thread = record->thread_.load(std::memory_order_relaxed);
+            thread.epoch = record->epoch_.load(std::memory_order_acquire);
+            thread.waiting_for = record->waiting_for_.load(std::memory_order_relaxed);
+            thread.timed = record->waiting_timed_.load(std::memory_order_relaxed);
+            thread.since = Clock::duration(
+                record->waiting_since_.load(std::memory_order_relaxed));
+            uint32_t count = std::min<uint32_t>(
+                record->held_count_.load(std::memory_order_acquire), kMaxHeld);
+            for (uint32_t i = 0; i < count; ++i) {
+                thread.held.push_back(record->held_[i].load(std::memory_order_relaxed));
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // Not waiting, or the wait ended or changed while we read
+            if (thread.epoch % 2 == 0 ||
+                record->epoch_.load(std::memory_order_relaxed) != thread.epoch) {
+                thread.waiting_for = nullptr;
+            }
+            threads.push_back(std::move(thread));
+        }
+        return threads;
+    }
+
+    // Cycles as lists of snapshot indices, each thread in at most one.
+    // Timed waits have no out edges.
+    static std::vector<std::vector<size_t>> find_cycles(
+        const std::vector<ThreadSnapshot> &threads) {
+        std::unordered_map<const void *, std::vector<size_t>> holders;
+        for (size_t i = 0; i < threads.size(); ++i) {
+            for (const void *lock : threads[i].held) {
+                holders[lock].push_back(i);
+            }
+        }
+        auto edges = [&](size_t i) -> const std::vector<size_t> & {
+            static const std::vector<size_t> none;
+            if (!threads[i].waiting_for || threads[i].timed) {
+                return none;
+            }
+            auto it = holders.find(threads[i].waiting_for);
+            return it == holders.end() ? none : it->second;
+        };
+
+        // Iterative DFS; a back edge to a node on the path closes a cycle
+        enum class Color : uint8_t { White, Grey, Black };
+        std::vector<Color> color(threads.size(), Color::White);
+        std::vector<std::vector<size_t>> cycles;
+        std::vector<std::pair<size_t, size_t>> path;  // (node, next edge)
+        for (size_t start = 0; start < threads.size(); ++start) {
+            if (color[start] != Color::White || edges(start).empty()) {
+                continue;
+            }
+            path.push_back({start, 0});
+            color[start] = Color::Grey;
+            while (!path.empty()) {
+                auto &[node, next] = path.back();
+                const auto &out = edges(node);
+                if (next == out.size()) {
+                    color[node] = Color::Black;
+                    path.pop_back();
+                    continue;
+                }
+                size_t to = out[next++];
+                if (color[to] == Color::White) {
+                    color[to] = Color::Grey;
+                    path.push_back({to, 0});
+                } else if (color[to] == Color::Grey) {
+                    auto from = std::find_if(path.begin(), path.end(),
+                                             [to](const auto &step) { return step.first == to; });
+                    auto &cycle = cycles.emplace_back();
+                    for (auto it = from; it != path.end(); ++it) {
+                        cycle.push_back(it->first);
+                    }
+                }
+            }
+        }
+        return cycles;
+    }
+};
+
+/**
+ * Wraps any of the library's locks (std::mutex, std::timed_mutex,
+ * std::shared_mutex, ReadWriteLock, ...) and reports holds and waits to
+ * LockMonitor::global(). Only the operations `Mutex` has are available.
+ * Uncontended acquisitions record the hold but no wait.
+ */
+template<typename Mutex = std::mutex>
+class MonitoredMutex {
+public:
+    MonitoredMutex() = default;
+    MonitoredMutex(const MonitoredMutex &) = delete;
+    MonitoredMutex &operator=(const MonitoredMutex &) = delete;
+
+    void lock() {
+        if constexpr (requires(Mutex &m) { m.try_lock(); }) {
+            if (mutex_.try_lock()) {
+                LockMonitor::this_thread().acquired(this);
+                return;
+            }
+        }
+        {
+            LockMonitor::WaitScope wait(this);
+            mutex_.lock();
+        }
+        LockMonitor::this_thread().acquired(this);
+    }
+
+    bool try_lock()
+        requires requires(Mutex &m) { m.try_lock(); }
+    {
+        return held_if(mutex_.try_lock());
+    }
+
+    template<typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period> &timeout)
+        requires requires(Mutex &m) { m.try_lock_for(timeout); }
+    {
+        if (mutex_.try_lock()) {
+            return held_if(true);
+        }
+        LockMonitor::WaitScope wait(this, true);
+        return held_if(mutex_.try_lock_for(timeout));
+    }
+
+    template<typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration> &deadline)
+        requires requires(Mutex &m) { m.try_lock_until(deadline); }
+    {
+        if (mutex_.try_lock()) {
+            return held_if(true);
+        }
+        LockMonitor::WaitScope wait(this, true);
+        return held_if(mutex_.try_lock_until(deadline));
+    }
+
+    void unlock() {
+        // Drop the record first so no one sees two holders
+        LockMonitor::this_thread().released(this);
+        mutex_.unlock();
+    }
+
+    // std::shared_mutex style
+    void lock_shared()
+        requires requires(Mutex &m) { m.lock_shared(); }
+    {
+        if (!mutex_.try_lock_shared()) {
+            LockMonitor::WaitScope wait(this);
+            mutex_.lock_shared();
+        }
+        LockMonitor::this_thread().acquired(this);
+    }
+
+    bool try_lock_shared()
+        requires requires(Mutex &m) { m.try_lock_shared(); }
+    {
+        return held_if(mutex_.try_lock_shared());
+    }
+
+    void unlock_shared()
+        requires requires(Mutex &m) { m.unlock_shared(); }
+    {
+        LockMonitor::this_thread().released(this);
+        mutex_.unlock_shared();
+    }
+
+    // ReadWriteLock style
+    void lock_read()
+        requires requires(Mutex &m) { m.lock_read(); }
+    {
+        {
+            LockMonitor::WaitScope wait(this);
+            mutex_.lock_read();
+        }
+        LockMonitor::this_thread().acquired(this);
+    }
+
+    void unlock_read()
+        requires requires(Mutex &m) { m.unlock_read(); }
+    {
+        LockMonitor::this_thread().released(this);
+        mutex_.unlock_read();
+    }
+
+    void lock_write()
+        requires requires(Mutex &m) { m.lock_write(); }
+    {
+        {
+            LockMonitor::WaitScope wait(this);
+            mutex_.lock_write();
+        }
+        LockMonitor::this_thread().acquired(this);
+    }
+
+    void unlock_write()
+        requires requires(Mutex &m) { m.unlock_write(); }
+    {
+        LockMonitor::this_thread().released(this);
+        mutex_.unlock_write();
+    }
+
+    Mutex &native() { return mutex_; }
+
+private:
+    Mutex mutex_;
+
+    bool held_if(bool acquired) {
+        if (acquired) {
+            LockMonitor::this_thread().acquired(this);
+        }
+        return acquired;
+    }
+};
+
+} // namespace concurrency
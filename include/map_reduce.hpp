@@ -0,0 +1,139 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace concurrency {
+
+/**
+ * Fan-out/fan-in over a finite dataset, the batch counterpart of
+ * ProducerConsumer.
+ * Workers claim chunks of `source` through an atomic cursor and fold
+ * map_fn results into a worker-private accumulator with reduce_fn. When the
+ * cursor runs past the end, partials are merged pairwise in a binary tree:
+ * worker i absorbs worker i + step once that worker's ready flag is set.
+ * No lock or shared completion counter is involved, and the calling thread
+ * acts as worker 0.
+ *
+ * reduce_fn(a, b) must be associative and commutative, since the chunk
+ * order is not fixed. Returns nullopt for an empty source. If map_fn or
+ * reduce_fn throws, the remaining chunks are skipped, every worker is
+ * joined and the first exception is rethrown.
+ */
+template<std::ranges::random_access_range Source, typename MapFn,
+         typename ReduceFn>
+auto map_reduce(Source &&source, MapFn map_fn, ReduceFn reduce_fn,
+                size_t workers = std::thread::hardware_concurrency())
+    -> std::optional<std::decay_t<
+        std::invoke_result_t<MapFn &, std::ranges::range_reference_t<Source>>>> {
+    using Result = std::decay_t<
+        std::invoke_result_t<MapFn &, std::ranges::range_reference_t<Source>>>;
+
+    const size_t count = std::ranges::size(source);
+    if (count == 0) {
+        return std::nullopt;
+    }
+    workers = std::clamp<size_t>(workers, 1, count);
+    // Several chunks per worker so uneven items still balance out
+    const size_t chunk = std::max<size_t>(1, count / (workers * 8));
+
+    struct alignas(64) Partial {
+        std::optional<Result> value;
+        std::atomic<bool> ready{false};
+    };
+    std::vector<Partial> partials(workers);
+    std::atomic<size_t> cursor{0};
+    auto first = std::ranges::begin(source);
+
+    auto combine = [&](std::optional<Result> &acc, Result &&value) {
+        if (acc) {
+            acc = std::invoke(reduce_fn, std::move(*acc), std::move(value));
+        } else {
+            acc.emplace(std::move(value));
+        }
+    };
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;  // Written once, by whoever sets failed
+    auto fail = [&](std::exception_ptr e) {
+        if (!failed.exchange(true)) {
+            error = std::move(e);
+        }
+    };
+
+    auto publish = [&](size_t id, std::optional<Result> &&value) {
+        partials[id].value = std::move(value);
+        partials[id].ready.store(true, std::memory_order_release);
+        partials[id].ready.notify_one();
+    };
+
+    auto worker = [&](size_t id) {
+        std::optional<Result> acc;
+        try {
+            while (!failed.load(std::memory_order_relaxed)) {
+                size_t begin = cursor.fetch_add(chunk, std::memory_order_relaxed);
+                if (begin >= count) {
+                    break;
+                }
+                size_t end = std::min(begin + chunk, count);
+                for (size_t i = begin; i < end; ++i) {
+                    combine(acc, std::invoke(map_fn, first[i]));
+                }
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+
+        // Tree merge: at each level, even workers absorb their partner.
+        // After a failure partners are still awaited, so that every ready
+        // flag gets published and no worker blocks forever.
+        for (size_t step = 1; step < workers; step *= 2) {
+            if (id % (2 * step) != 0) {
+                break;  // Hand our partial to worker id - step
+            }
+            size_t partner = id + step;
+            if (partner >= workers) {
+                continue;
+            }
+            partials[partner].ready.wait(false, std::memory_order_acquire);
+            if (partials[partner].value && !failed.load()) {
+                try {
+                    combine(acc, std::move(*partials[partner].value));
+                } catch (...) {
+                    fail(std::current_exception());
+                }
+            }
+        }
+        publish(id, std::move(acc));
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t id = 1; id < workers; ++id) {
+        try {
+            threads.emplace_back(worker, id);
+        } catch (...) {
+            // Publish empty partials for the workers that never started
+            fail(std::current_exception());
+            for (; id < workers; ++id) {
+                publish(id, std::nullopt);
+            }
+        }
+    }
+    worker(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return std::move(partials[0].value);
+}
+
+} // namespace concurrency
@@ -0,0 +1,148 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace concurrency {
+
+namespace detail {
+// Stripe slot of the calling thread, handed out round robin
+inline size_t stripe_slot() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+} // namespace detail
+
+/**
+ * Event counter split over cache-line-sized stripes, one per thread (mod
+ * kStripes), so threads counting at the same time don't fight over one
+ * cache line. load() sums the stripes; under concurrent updates it is a
+ * snapshot, not a linearizable read.
+ */
+class StripedCounter {
+public:
+    static constexpr size_t kStripes = 16;
+
+    void add(uint64_t n = 1) {
+        stripes_[detail::stripe_slot() % kStripes].value.fetch_add(
+            n, std::memory_order_relaxed);
+    }
+
+    uint64_t load() const {
+        uint64_t total = 0;
+        for (const auto &stripe : stripes_) {
+            total += stripe.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Stripe, kStripes> stripes_;
+};
+
+/**
+ * Duration histogram with power-of-two nanosecond buckets, striped like
+ * StripedCounter. Bucket b holds durations in [2^(b-1), 2^b) ns, bucket 0
+ * holds zero and the last bucket is open ended.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 48;  // Last bucket starts at ~39 hours
+
+    struct Snapshot {
+        std::array<uint64_t, kBuckets> buckets{};
+
+        uint64_t count() const {
+            uint64_t total = 0;
+            for (uint64_t n : buckets) {
+                total += n;
+            }
+            return total;
+        }
+
+        /**
+         * Upper bound of the bucket holding quantile q (0 < q <= 1),
+         * zero if nothing was recorded
+         */
+        std::chrono::nanoseconds percentile(double q) const {
+            uint64_t total = count();
+            if (total == 0) {
+                return std::chrono::nanoseconds(0);
+            }
+            auto rank = static_cast<uint64_t>(q * static_cast<double>(total));
+            uint64_t seen = 0;
+            for (size_t b = 0; b < kBuckets; ++b) {
+                seen += buckets[b];
+                if (seen >= std::max<uint64_t>(rank, 1)) {
+                    return upper_bound(b);
+                }
+            }
+            return upper_bound(kBuckets - 1);
+        }
+    };
+
+    void record(std::chrono::nanoseconds duration) {
+        auto ns = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+        size_t bucket = std::min<size_t>(std::bit_width(ns), kBuckets - 1);
+        stripes_[detail::stripe_slot() % StripedCounter::kStripes]
+            .buckets[bucket]
+            .fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot result;
+        for (const auto &stripe : stripes_) {
+            for (size_t b = 0; b < kBuckets; ++b) {
+                result.buckets[b] += stripe.buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+        return result;
+    }
+
+    static std::chrono::nanoseconds upper_bound(size_t bucket) {
+        if (bucket + 1 >= kBuckets) {
+            return std::chrono::nanoseconds::max();
+        }
+        return std::chrono::nanoseconds(int64_t{1} << bucket);
+    }
+
+private:
+    struct alignas(64) Stripe {
+        std::array<std::atomic<uint64_t>, kBuckets> buckets{};
+    };
+    std::array<Stripe, StripedCounter::kStripes> stripes_;
+};
+
+/**
+ * One point of a pool's utilization time series
+ */
+struct UtilizationSample {
+    std::chrono::steady_clock::time_point at;
+    size_t in_use;       // At the sample
+    size_t peak_in_use;  // Highest during the interval ending at the sample
+};
+
+/**
+ * Point-in-time copy of a pool's instrumentation
+ */
+struct PoolMetrics {
+    size_t capacity{0};
+    size_t in_use{0};
+    size_t peak_usage{0};
+    uint64_t acquisitions{0};
+    uint64_t releases{0};
+    uint64_t timeouts{0};
+    LatencyHistogram::Snapshot wait_time;  // From request to resource in hand
+    LatencyHistogram::Snapshot hold_time;  // From acquisition to release
+    std::vector<UtilizationSample> utilization;  // Oldest first
+};
+
+} // namespace concurrency
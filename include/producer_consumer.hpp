@@ -2,23 +2,157 @@
 #include <condition_variable>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
 #include <vector>
 #include <functional>
-#include <queue>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include "rate_limiter.hpp"
 
 namespace concurrency {
 
+/**
+ * CoDel (Controlled Delay) queue-delay controller.
+ * Once the time items spend in the buffer stays above `target` for a whole
+ * `interval`, items are dropped at dequeue with a spacing of
+ * interval / sqrt(drop_count) until the delay falls back below target.
+ * Not thread-safe: callers hold the buffer lock.
+ */
+class CoDelController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CoDelController(Clock::duration target, Clock::duration interval)
+        : target_(target), interval_(interval) {}
+
+    /**
+     * Decide whether the item dequeued at `now` after waiting `sojourn`
+     * should be dropped. `queue_drained` is true when it was the last item.
+     */
+    bool should_drop(Clock::duration sojourn, Clock::time_point now,
+                     bool queue_drained) {
+        bool ok_to_drop = false;
+        if (sojourn < target_ || queue_drained) {
+            first_above_time_ = Clock::time_point{};
+        } else if (first_above_time_ == Clock::time_point{}) {
+            first_above_time_ = now + interval_;
+        } else if (now >= first_above_time_) {
+            ok_to_drop = true;
+        }
+
+        if (dropping_) {
+            if (!ok_to_drop) {
+                dropping_ = false;
+                return false;
+            }
+            if (now >= drop_next_) {
+                ++drop_count_;
+                drop_next_ = control_law(drop_next_);
+                return true;
+            }
+            return false;
+        }
+        if (ok_to_drop) {
+            dropping_ = true;
+            // Re-enter near the previous drop rate if we left it recently
+            drop_count_ = (drop_count_ > 2 && now - drop_next_ < 16 * interval_)
+                              ? drop_count_ - 2
+                              : 1;
+            drop_next_ = control_law(now);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    Clock::duration target_;
+    Clock::duration interval_;
+    Clock::time_point first_above_time_{};
+    Clock::time_point drop_next_{};
+    size_t drop_count_{0};
+    bool dropping_{false};
+
+    Clock::time_point control_law(Clock::time_point t) const {
+        return t + std::chrono::duration_cast<Clock::duration>(
+                       interval_ / std::sqrt(static_cast<double>(drop_count_)));
+    }
+};
+
 /**
  * Producer-Consumer pattern with bounded buffer.
  * Demonstrates proper use of condition variables.
+ * Buffer storage comes from `Allocator`; see pmr::ProducerConsumer.
  */
-template<typename T>
+template<typename T, typename Allocator = std::allocator<T>>
 class ProducerConsumer {
 public:
-    explicit ProducerConsumer(size_t buffer_size) : buffer_size_(buffer_size) {}
+    using Clock = std::chrono::steady_clock;
+
+    explicit ProducerConsumer(size_t buffer_size,
+                              const Allocator &alloc = Allocator())
+        : buffer_size_(buffer_size), buffer_(EntryAllocator(alloc)) {}
     ~ProducerConsumer() {}
 
-    
+    /**
+     * Give items a deadline. Items whose deadline has passed when a consumer
+     * dequeues them are shed without calling consumer_func.
+     * Must be called before start().
+     */
+    void set_deadline(std::function<Clock::time_point(const T &)> deadline_of) {
+        deadline_of_ = std::move(deadline_of);
+    }
+
+    /**
+     * Enable CoDel load shedding to keep buffer latency near `target`.
+     * Must be called before start().
+     */
+    void enable_codel(Clock::duration target = std::chrono::milliseconds(5),
+                      Clock::duration interval = std::chrono::milliseconds(100)) {
+        codel_.emplace(target, interval);
+    }
+
+    /**
+     * Pace consumer_func calls through a shared rate limiter. The same
+     * limiter may be shared with other stages that call the same dependency.
+     * A consumer takes its permit before dequeuing, so the item waits in the
+     * buffer, where it can still be shed or coalesced. The cap holds through
+     * stop(): items left that no consumer has a due permit for are dropped
+     * (counted in items_dropped()) rather than passed on in a burst.
+     * Must be called before start().
+     */
+    void set_rate_limiter(std::shared_ptr<RateLimiter> limiter) {
+        rate_limiter_ = std::move(limiter);
+    }
+
+    /**
+     * Coalesce pending items by key: an item whose key is already waiting in
+     * the buffer is merged into that item in place instead of taking a new
+     * slot, so consumers only see the latest (or merged) state per key.
+     * `merge(pending, incoming)` defaults to replacing the pending item and
+     * must not change its key. Must be called before start().
+     */
+    template<typename KeyOf>
+    void enable_coalescing(KeyOf key_of,
+                           std::function<void(T &, T &&)> merge = {}) {
+        using Key = std::decay_t<std::invoke_result_t<KeyOf &, const T &>>;
+        coalescer_ = std::make_unique<KeyedCoalescer<Key, KeyOf>>(
+            std::move(key_of));
+        if (merge) {
+            merge_ = std::move(merge);
+        } else {
+            merge_ = [](T &pending, T &&incoming) {
+                pending = std::move(incoming);
+            };
+        }
+    }
+
     /**
      * Start specified number of producer and consumer threads
      */
@@ -37,7 +171,12 @@ public:
     }
 
     void stop() {
-        running_ = false;
+        {
+            // Under the lock, so no waiter checks the flag and then misses
+            // the notify
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
         not_full_.notify_all();
         for (auto &thread : producer_threads_) {
             if (thread.joinable()) {
@@ -46,6 +185,7 @@ public:
         }
         producer_threads_.clear();
         not_empty_.notify_all();
+        rate_wait_.notify_all();
 
         for (auto &thread : consumer_threads_) {
             if (thread.joinable()) {
@@ -60,6 +200,10 @@ public:
      */
     size_t items_produced() const { return items_produced_.load(); }
     size_t items_consumed() const { return items_consumed_.load(); }
+    size_t items_expired() const { return items_expired_.load(); }
+    size_t items_dropped() const { return items_dropped_.load(); }
+    size_t items_shed() const { return items_expired() + items_dropped(); }
+    size_t items_coalesced() const { return items_coalesced_.load(); }
     size_t current_buffer_size() const
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -67,12 +211,52 @@ public:
     }
 
 private:
+    struct Entry {
+        T item;
+        Clock::time_point enqueued;
+        Clock::time_point deadline;
+    };
+
+    // Key -> buffer slot index for coalescing. Slots are addressed by a
+    // sequence number that stays stable while the item waits in the buffer.
+    struct Coalescer {
+        virtual ~Coalescer() = default;
+        virtual std::optional<uint64_t> find(const T &item) const = 0;
+        virtual void insert(const T &item, uint64_t seq) = 0;
+        virtual void erase(const T &item) = 0;
+    };
+
+    template<typename Key, typename KeyOf>
+    struct KeyedCoalescer : Coalescer {
+        explicit KeyedCoalescer(KeyOf key_of) : key_of_(std::move(key_of)) {}
+
+        std::optional<uint64_t> find(const T &item) const override {
+            auto it = index_.find(key_of_(item));
+            if (it == index_.end()) {
+                return std::nullopt;
+            }
+            return it->second;
+        }
+        void insert(const T &item, uint64_t seq) override {
+            index_.emplace(key_of_(item), seq);
+        }
+        void erase(const T &item) override { index_.erase(key_of_(item)); }
+
+        mutable KeyOf key_of_;
+        std::unordered_map<Key, uint64_t> index_;
+    };
+
+    using EntryAllocator =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<Entry>;
+
     size_t buffer_size_;
     // Bounded buffer implementation
-    std::queue<T> buffer_;
+    std::deque<Entry, EntryAllocator> buffer_;
+    uint64_t head_seq_{0};  // Sequence number of buffer_.front()
     mutable std::mutex mutex_;
     std::condition_variable not_full_;   // Signals producers when space available
     std::condition_variable not_empty_;  // Signals consumers when items available
+    std::condition_variable rate_wait_;  // Wakes paced consumers on stop()
     
     // Thread management
     std::vector<std::thread> producer_threads_;
@@ -81,32 +265,100 @@ private:
     // Statistics
     std::atomic<size_t> items_produced_{0};
     std::atomic<size_t> items_consumed_{0};
+    std::atomic<size_t> items_expired_{0};  // Shed: deadline passed
+    // Shed: CoDel, or left at stop() with no rate-limit permit due
+    std::atomic<size_t> items_dropped_{0};
+    std::atomic<size_t> items_coalesced_{0};
     std::atomic<bool> running_{false};
+
+    // Load shedding
+    std::function<Clock::time_point(const T &)> deadline_of_;
+    std::optional<CoDelController> codel_;  // Guarded by mutex_
+
+    bool shedding_enabled() const { return deadline_of_ || codel_; }
+
+    std::shared_ptr<RateLimiter> rate_limiter_;
+
+    // Coalescing, guarded by mutex_
+    std::unique_ptr<Coalescer> coalescer_;
+    std::function<void(T &, T &&)> merge_;
+
+    // Merge into a pending item with the same key, if there is one
+    bool coalesce_into_pending(Entry &entry) {
+        if (!coalescer_) {
+            return false;
+        }
+        auto seq = coalescer_->find(entry.item);
+        if (!seq) {
+            return false;
+        }
+        Entry &pending = buffer_[*seq - head_seq_];
+        merge_(pending.item, std::move(entry.item));
+        if (deadline_of_) {
+            pending.deadline = deadline_of_(pending.item);
+        }
+        return true;
+    }
     
     // Worker functions
     void producer_worker(std::function<T()> producer_func) {
         while (running_.load()) {
             auto item = producer_func();
-            
+            Entry entry{std::move(item), Clock::time_point{},
+                        Clock::time_point::max()};
+            if (shedding_enabled()) {
+                entry.enqueued = Clock::now();
+                if (deadline_of_) {
+                    entry.deadline = deadline_of_(entry.item);
+                }
+            }
+
             {
             std::unique_lock<std::mutex> lock(mutex_);
-                not_full_.wait(lock, [this]() { 
-                    return buffer_.size() < buffer_size_ || !running_.load(); 
+                // A pending item with the same key can absorb this one even
+                // when the buffer is full
+                not_full_.wait(lock, [this, &entry]() { 
+                    return buffer_.size() < buffer_size_ || !running_.load() ||
+                           (coalescer_ && coalescer_->find(entry.item));
                 });
                 
                 // Check again after wait - exit if stopped
                 if (!running_.load()) {
                     break;
                 }
+
+                if (coalesce_into_pending(entry)) {
+                    items_produced_.fetch_add(1);
+                    items_coalesced_.fetch_add(1);
+                    continue;  // No new item for consumers
+                }
                 
-                buffer_.push(item);
+                if (coalescer_) {
+                    coalescer_->insert(entry.item,
+                                       head_seq_ + buffer_.size());
+                }
+                buffer_.push_back(std::move(entry));
                 items_produced_.fetch_add(1);  // Only increment after successful push
             }
             
             not_empty_.notify_one();
         }
     }
+    // Drop everything still buffered. Called with mutex_ held.
+    void drop_remaining() {
+        items_dropped_.fetch_add(buffer_.size());
+        if (coalescer_) {
+            for (const auto &entry : buffer_) {
+                coalescer_->erase(entry.item);
+            }
+        }
+        head_seq_ += buffer_.size();
+        buffer_.clear();
+    }
+
     void consumer_worker(std::function<void(T)> consumer_func) {
+        // Reserved rate-limiter slot not yet used
+        std::optional<Clock::time_point> permit;
         while (true) {
             std::unique_lock<std::mutex> lock(mutex_);
             not_empty_.wait(lock, [this]() { return !buffer_.empty() || !running_.load(); });
@@ -116,16 +368,63 @@ private:
                 lock.unlock();
                 break;
             }
+
+            if (rate_limiter_) {
+                if (!permit && running_.load()) {
+                    // Wait for the slot with the item still queued; stop()
+                    // wakes us
+                    permit = rate_limiter_->reserve();
+                    rate_wait_.wait_until(lock, *permit,
+                                          [this]() { return !running_.load(); });
+                    if (buffer_.empty()) {
+                        continue;  // Taken by another consumer; keep the permit
+                    }
+                }
+                if (!permit || Clock::now() < *permit) {
+                    // Stopped before our next slot: consuming now would
+                    // break the cap
+                    drop_remaining();
+                    continue;
+                }
+            }
             
-            auto item = buffer_.front();
-            buffer_.pop();
+            if (coalescer_) {
+                coalescer_->erase(buffer_.front().item);
+            }
+            auto entry = std::move(buffer_.front());
+            buffer_.pop_front();
+            ++head_seq_;
+
+            bool expired = false;
+            bool dropped = false;
+            if (shedding_enabled()) {
+                auto now = Clock::now();
+                expired = entry.deadline < now;
+                if (!expired && codel_) {
+                    dropped = codel_->should_drop(now - entry.enqueued, now,
+                                                  buffer_.empty());
+                }
+            }
             lock.unlock();
-            
-            items_consumed_.fetch_add(1);
-            consumer_func(item);
+
+            if (expired) {
+                items_expired_.fetch_add(1);
+            } else if (dropped) {
+                items_dropped_.fetch_add(1);
+            } else {
+                permit.reset();
+                items_consumed_.fetch_add(1);
+                consumer_func(std::move(entry.item));
+            }
             not_full_.notify_one();
         }
     }
 };
+namespace pmr {
+template<typename T>
+using ProducerConsumer =
+    concurrency::ProducerConsumer<T, std::pmr::polymorphic_allocator<T>>;
+} // namespace pmr
+
 } // namespace concurrency
 // namespace concurrency
\ No newline at end of file
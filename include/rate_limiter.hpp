@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+namespace concurrency {
+
+/**
+ * Lock-free rate limiter based on the Generic Cell Rate Algorithm (GCRA),
+ * the continuous-time form of a token bucket.
+ * Allows `permits_per_second` on average with bursts of up to `burst`
+ * permits. All shared state is a single atomic "theoretical arrival time",
+ * so one limiter can be shared by any number of threads.
+ */
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit RateLimiter(double permits_per_second, size_t burst = 1)
+        : epoch_(Clock::now()) {
+        if (permits_per_second <= 0 || burst == 0) {
+            throw std::invalid_argument("RateLimiter needs a positive rate "
+                                        "and burst");
+        }
+        interval_ns_ = static_cast<int64_t>(1e9 / permits_per_second);
+        tolerance_ns_ = interval_ns_ * static_cast<int64_t>(burst - 1);
+    }
+
+    RateLimiter(const RateLimiter &) = delete;
+    RateLimiter &operator=(const RateLimiter &) = delete;
+
+    /**
+     * Take a permit if one is available right now. Never blocks.
+     */
+    bool try_acquire() {
+        int64_t now = now_ns();
+        int64_t tat = tat_.load(std::memory_order_relaxed);
+        do {
+            if (tat - tolerance_ns_ > now) {
+                return false;
+            }
+        } while (!tat_.compare_exchange_weak(tat,
+                                             std::max(tat, now) + interval_ns_,
+                                             std::memory_order_relaxed));
+        return true;
+    }
+
+    /**
+     * Reserve the next permit and return the time at which it may be used.
+     * The reservation cannot be cancelled.
+     */
+    Clock::time_point reserve() {
+        int64_t now = now_ns();
+        int64_t tat = tat_.load(std::memory_order_relaxed);
+        while (!tat_.compare_exchange_weak(tat,
+                                           std::max(tat, now) + interval_ns_,
+                                           std::memory_order_relaxed)) {
+        }
+        int64_t ready = std::max(tat - tolerance_ns_, now);
+        return epoch_ + std::chrono::nanoseconds(ready);
+    }
+
+    /**
+     * Take a permit, sleeping until its slot if the limit is exceeded.
+     * Waiters get distinct slots, so they wake paced rather than all at once.
+     */
+    void acquire() {
+        auto ready = reserve();
+        if (ready > Clock::now()) {
+            std::this_thread::sleep_until(ready);
+        }
+    }
+
+private:
+    Clock::time_point epoch_;
+    int64_t interval_ns_;   // Time between permits at the steady rate
+    int64_t tolerance_ns_;  // How far ahead of schedule a burst may run
+    std::atomic<int64_t> tat_{0};  // Theoretical arrival time, ns since epoch_
+
+    int64_t now_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   Clock::now() - epoch_)
+            .count();
+    }
+};
+
+} // namespace concurrency
@@ -1,14 +1,151 @@
 #pragma once
 #include <semaphore>
 #include <vector>
-#include <queue>
+#include <deque>
 #include <mutex>
 #include <memory>
 #include <chrono>
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#include "coroutine_scheduler.hpp"
+#include "lock_free_index_stack.hpp"
+#include "pool_metrics.hpp"
 
 namespace concurrency {
 
+/**
+ * How a ResourcePool keeps track of its free resources
+ */
+enum class FreeListKind {
+    FifoQueue,      // Queue guarded by a mutex: rotates through every resource
+    LifoStack,      // Stack guarded by a mutex: most recently released first
+    LockFreeStack,  // Tagged-index Treiber stack (LIFO), no mutex on any path
+    CpuAffinity,    // One lock-free stack per CPU: a resource goes back to the
+                    // stack of the CPU that released it, and acquire prefers
+                    // the caller's CPU before scanning the others
+};
+
+namespace detail {
+// CPU the calling thread runs on right now, or a per-thread stand-in
+// (stable per thread at least) where the platform can't tell
+inline size_t current_cpu() {
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (cpu >= 0) {
+        return static_cast<size_t>(cpu);
+    }
+#endif
+    return stripe_slot();
+}
+} // namespace detail
+
+/**
+ * Priority class of a queued acquire. Released resources go to the highest
+ * class first, FIFO within a class. A request's class rises as it waits
+ * (see ResourcePool::set_priority_aging), so Low is not starved by High.
+ */
+enum class AcquirePriority { Low, Normal, High };
+
+template<typename Resource>
+class ResourcePool;
+
+/**
+ * Move-only handle to a resource borrowed from a ResourcePool.
+ * Just a pool pointer, a 32-bit slot index and the slot's generation, so
+ * creating, moving and releasing it never allocates or touches a reference
+ * count. The resource returns to the pool when the handle is destroyed or
+ * reset.
+ */
+template<typename Resource>
+class PoolHandle {
+public:
+    PoolHandle() = default;
+    ~PoolHandle() { reset(); }
+
+    PoolHandle(const PoolHandle &) = delete;
+    PoolHandle &operator=(const PoolHandle &) = delete;
+
+    PoolHandle(PoolHandle &&other) noexcept
+        : pool_(std::exchange(other.pool_, nullptr)), index_(other.index_),
+          generation_(other.generation_) {}
+
+    PoolHandle &operator=(PoolHandle &&other) noexcept {
+        if (this != &other) {
+            reset();
+            pool_ = std::exchange(other.pool_, nullptr);
+            index_ = other.index_;
+            generation_ = other.generation_;
+        }
+        return *this;
+    }
+
+    Resource *get() const { return pool_ ? pool_->resource_at(index_) : nullptr; }
+    Resource *operator->() const { return get(); }
+    Resource &operator*() const { return *get(); }
+    explicit operator bool() const { return pool_ != nullptr; }
+
+    uint32_t index() const { return index_; }
+    uint32_t generation() const { return generation_; }
+
+    /**
+     * Return the resource to the pool now
+     */
+    void reset() {
+        if (pool_) {
+            std::exchange(pool_, nullptr)->release_handle(index_, generation_);
+        }
+    }
+
+private:
+    friend class ResourcePool<Resource>;
+    PoolHandle(ResourcePool<Resource> *pool, uint32_t index, uint32_t generation)
+        : pool_(pool), index_(index), generation_(generation) {}
+
+    ResourcePool<Resource> *pool_ = nullptr;
+    uint32_t index_ = 0;
+    uint32_t generation_ = 0;
+};
+
+/**
+ * Move-only set of resources acquired together by ResourcePool::acquire_n.
+ * All of them return to the pool when the batch is destroyed or reset.
+ */
+template<typename Resource>
+class PoolBatch {
+public:
+    PoolBatch() = default;
+
+    size_t size() const { return handles_.size(); }
+    bool empty() const { return handles_.empty(); }
+    explicit operator bool() const { return !handles_.empty(); }
+
+    Resource &operator[](size_t i) const { return *handles_[i]; }
+    auto begin() const { return handles_.begin(); }
+    auto end() const { return handles_.end(); }
+
+    void reset() { handles_.clear(); }
+
+private:
+    friend class ResourcePool<Resource>;
+    explicit PoolBatch(std::vector<PoolHandle<Resource>> handles)
+        : handles_(std::move(handles)) {}
+
+    std::vector<PoolHandle<Resource>> handles_;
+};
+
 /**
  * Resource Pool using semaphores to limit concurrent access.
  * Demonstrates proper use of counting semaphores for resource management.
@@ -17,49 +154,194 @@ namespace concurrency {
  */
 template<typename Resource>
 class ResourcePool {
+    enum class WaiterState { Pending, Fulfilled, Taken, Cancelled };
+    struct Waiter;
+
 public:
-    explicit ResourcePool(size_t pool_size) 
+    using Clock = std::chrono::steady_clock;
+    using Handle = PoolHandle<Resource>;
+    using Batch = PoolBatch<Resource>;
+
+    // Resources are constructed from their id, first_id + slot index
+    explicit ResourcePool(size_t pool_size,
+                          FreeListKind free_list = FreeListKind::FifoQueue,
+                          size_t first_id = 0) 
         : available_resources_(pool_size)  // Semaphore initialized with pool size
-        , total_acquisitions_(0)
-        , total_releases_(0)
+        , storage_(std::make_shared<Storage>(pool_size, first_id))
+        , free_list_kind_(free_list)
+        , free_stack_(free_list == FreeListKind::LockFreeStack ? pool_size : 0)
+        , in_use_(0)
         , peak_usage_(0) {
         
-        // Pre-populate the pool with resources
+        // shared_ptr views for acquire(): one control block per slot, each
+        // keeping the storage alive, so copies don't contend on one count
+        shared_.reserve(pool_size);
         for (size_t i = 0; i < pool_size; ++i) {
-            std::lock_guard<std::mutex> lock(pool_mutex_);
-            resource_pool_.push(std::make_shared<Resource>(i));
+            shared_.emplace_back(&storage_->resources[i],
+                                 [keep = storage_](Resource *) {});
+        }
+        if (free_list_kind_ == FreeListKind::CpuAffinity) {
+            size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+            for (size_t cpu = 0; cpu < cpus; ++cpu) {
+                cpu_stacks_.push_back(std::make_unique<LockFreeIndexStack>(pool_size));
+            }
+        }
+        // Stacks hand out the last push first, so fill them in reverse to
+        // start every kind at slot 0. Affinity stacks start out dealt round
+        // robin, as if each resource was last used on CPU index % cpus.
+        for (size_t i = 0; i < pool_size; ++i) {
+            size_t index =
+                free_list_kind_ == FreeListKind::FifoQueue ? i : pool_size - 1 - i;
+            if (free_list_kind_ == FreeListKind::CpuAffinity) {
+                cpu_stacks_[index % cpu_stacks_.size()]->push(
+                    static_cast<uint32_t>(index));
+            } else {
+                put_free(static_cast<uint32_t>(index));
+            }
         }
     }
 
+    ~ResourcePool() {
+        if (reaper_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(waiters_mutex_);
+                reaper_stopping_ = true;
+            }
+            reaper_cv_.notify_all();
+            reaper_.join();
+        }
+        // Coroutines still queued for resumption may touch the pool, and a
+        // handle they release can queue another one, so drain before the
+        // pointer goes away
+        if (resumer_) {
+            resumer_->shutdown();
+            resumer_.reset();
+        }
+        if (metrics_) {
+            metrics_->stop_sampler();
+        }
+        if (cache_owner_) {
+            // Thread caches that outlive the pool just drop their resources
+            std::lock_guard<std::mutex> lock(cache_owner_->mutex);
+            cache_owner_->pool = nullptr;
+        }
+    }
+
+    ResourcePool(const ResourcePool &) = delete;
+    ResourcePool &operator=(const ResourcePool &) = delete;
+
     /**
-     * Acquire a resource from the pool (blocking)
-     * Uses semaphore to limit concurrent access
+     * Park up to `per_thread` released resources in a cache private to the
+     * releasing thread, so a thread that keeps borrowing and returning is
+     * served without touching the semaphore or the pool lock.
+     * Releases beyond that overflow to the shared pool, and a thread's cache
+     * is returned to the pool when the thread exits.
+     * Parked resources still count as in use, but they are never stranded:
+     * a thread about to block, or a request joining the waiter queue,
+     * steals them, and nothing is parked while anyone is waiting.
+     * A cache hit or park writes only the slot's own cache line (its
+     * generation and parked flag) and the thread's own counters. The
+     * parked flag is kept on purpose: the owner and a thief both claim
+     * the slot by clearing it, so one of them wins.
+     * Must be called before the pool is shared between threads.
      */
-    std::shared_ptr<Resource> acquire() {
-        // Wait for available resource (semaphore decrements)
-        available_resources_.acquire();
-        
-        std::shared_ptr<Resource> resource;
-        {
-            std::lock_guard<std::mutex> lock(pool_mutex_);
-            if (!resource_pool_.empty()) {
-                resource = resource_pool_.front();
-                resource_pool_.pop();
+    void enable_thread_cache(size_t per_thread) {
+        thread_cache_size_ = per_thread;
+        if (!cache_owner_) {
+            cache_owner_ = std::make_shared<CacheOwner>();
+            cache_owner_->pool = this;
+        }
+    }
+
+    /**
+     * Resume coroutines suspended in acquire_async() through `executor`,
+     * e.g. `[&](auto h) { scheduler.post(h); }`. It is called from inside
+     * the pool, possibly under a pool lock, so it should only queue the
+     * handle. Without one, coroutines are posted to a single worker thread
+     * owned by the pool, started on first use.
+     * Must be called before the pool is shared between threads.
+     */
+    void set_executor(std::function<void(std::coroutine_handle<>)> executor) {
+        executor_ = std::move(executor);
+    }
+
+    /**
+     * Return the calling thread's cached resources to the shared pool
+     */
+    void flush_thread_cache() {
+        if (!cache_owner_) {
+            return;
+        }
+        for (auto &entry : thread_cache().entries) {
+            if (entry.owner == cache_owner_) {
+                flush(entry);
             }
         }
-        
-        // Update statistics
-        total_acquisitions_.fetch_add(1);
-        size_t current_usage = total_acquisitions_.load() - total_releases_.load();
-        
-        // Update peak usage atomically
-        size_t current_peak = peak_usage_.load();
-        while (current_usage > current_peak && 
-               !peak_usage_.compare_exchange_weak(current_peak, current_usage)) {
-            current_peak = peak_usage_.load();
+    }
+
+    /**
+     * Record acquire wait times, hold times and a utilization time series:
+     * every `sample_interval` a background thread samples current and
+     * interval-peak usage, keeping the last `history` samples.
+     * Histograms are striped per thread. Costs two clock reads per borrow.
+     * Must be called before the pool is shared between threads.
+     */
+    void enable_metrics(std::chrono::milliseconds sample_interval =
+                            std::chrono::milliseconds(100),
+                        size_t history = 600) {
+        if (metrics_) {
+            return;
         }
-        
-        return resource;
+        metrics_ = std::make_unique<Metrics>(shared_.size(), history);
+        metrics_->sampler = std::thread([this, sample_interval]() {
+            sample_loop(sample_interval);
+        });
+    }
+
+    /**
+     * Snapshot of counters, histograms and utilization samples. Histograms
+     * and samples stay empty unless enable_metrics() was called.
+     */
+    PoolMetrics metrics() const {
+        PoolMetrics result;
+        result.capacity = shared_.size();
+        result.in_use = current_usage();
+        result.peak_usage = peak_usage();
+        result.acquisitions = total_acquisitions();
+        result.releases = total_releases();
+        result.timeouts = total_timeouts();
+        if (metrics_) {
+            result.wait_time = metrics_->wait_time.snapshot();
+            result.hold_time = metrics_->hold_time.snapshot();
+            std::lock_guard<std::mutex> lock(metrics_->samples_mutex);
+            result.utilization.assign(metrics_->samples.begin(),
+                                      metrics_->samples.end());
+        }
+        return result;
+    }
+
+    /**
+     * Route acquire() and try_acquire() (and their handle forms) through
+     * the FIFO waiter queue at Normal priority. Blocked threads are then
+     * served strictly in arrival order instead of in whatever order the
+     * semaphore wakes them. Must be called before the pool is shared.
+     */
+    void enable_fair_queueing() { fair_ = true; }
+
+    /**
+     * Raise a queued request one priority class for every `step` it has
+     * waited, up to High; ties go to the earlier arrival. Keeps sustained
+     * High traffic from starving Low. Zero gives strict priority.
+     * Must be called before the pool is shared between threads.
+     */
+    void set_priority_aging(Clock::duration step) { aging_step_ = step; }
+
+    /**
+     * Acquire a resource from the pool (blocking)
+     * Uses semaphore to limit concurrent access
+     */
+    std::shared_ptr<Resource> acquire() {
+        return shared_[acquire_index()];
     }
 
     /**
@@ -67,22 +349,11 @@ public:
      * Demonstrates timed semaphore operations
      */
     std::shared_ptr<Resource> try_acquire(std::chrono::milliseconds timeout) {
-        // Try to acquire with timeout
-        if (!available_resources_.try_acquire_for(timeout)) {
+        auto index = try_acquire_index(timeout);
+        if (!index) {
             return nullptr;  // Timeout - no resource available
         }
-        
-        std::shared_ptr<Resource> resource;
-        {
-            std::lock_guard<std::mutex> lock(pool_mutex_);
-            if (!resource_pool_.empty()) {
-                resource = resource_pool_.front();
-                resource_pool_.pop();
-            }
-        }
-        
-        total_acquisitions_.fetch_add(1);
-        return resource;
+        return shared_[*index];
     }
 
     /**
@@ -90,77 +361,1117 @@ public:
      */
     void release(std::shared_ptr<Resource> resource) {
         if (!resource) return;
-        
-        {
-            std::lock_guard<std::mutex> lock(pool_mutex_);
-            resource_pool_.push(resource);
+        release_index(index_of(resource.get()));
+    }
+
+    /**
+     * Acquire as a move-only handle instead of a shared_ptr (blocking)
+     */
+    Handle acquire_handle() {
+        uint32_t index = acquire_index();
+        return Handle(this, index, generation_of(index));
+    }
+
+    /**
+     * Acquire through the waiter queue with a priority class and an
+     * optional deadline. Empty handle if the deadline passes first.
+     */
+    Handle acquire_handle(AcquirePriority priority,
+                          std::optional<Clock::time_point> deadline = std::nullopt) {
+        auto index = acquire_queued(priority, deadline);
+        if (!index) {
+            return Handle();
         }
-        
-        total_releases_.fetch_add(1);
-        
-        // Signal that a resource is now available (semaphore increments)
-        available_resources_.release();
+        return Handle(this, *index, generation_of(*index));
+    }
+
+    /**
+     * Try to acquire a handle with timeout. Empty handle on timeout.
+     */
+    Handle try_acquire_handle(std::chrono::milliseconds timeout) {
+        auto index = try_acquire_index(timeout);
+        if (!index) {
+            return Handle();
+        }
+        return Handle(this, *index, generation_of(*index));
+    }
+
+    /**
+     * Take a resource only if one is free right now, without waiting or
+     * joining the queue. A miss is not a timeout and isn't counted.
+     */
+    Handle try_take_handle() {
+        auto start = wait_start();
+        std::optional<uint32_t> index;
+        if (thread_cache_size_ != 0) {
+            index = take_cached();
+        }
+        // Under fair queueing, don't overtake queued requests
+        if (!index && (!fair_ || num_waiters_.load() == 0) &&
+            available_resources_.try_acquire()) {
+            index = take_free();
+            record_acquisition();
+        }
+        if (!index) {
+            return Handle();
+        }
+        note_acquired(*index, start);
+        return Handle(this, *index, generation_of(*index));
+    }
+
+    /**
+     * Acquire `count` resources as one unit (blocking). The request waits
+     * in the waiter queue; once at the head it collects every released
+     * resource until it has all of them, so concurrent batches cannot
+     * deadlock on partial sets and later requests cannot starve it.
+     * Throws std::invalid_argument unless 0 < count <= pool size.
+     */
+    Batch acquire_n(size_t count,
+                    AcquirePriority priority = AcquirePriority::Normal) {
+        return acquire_batch(count, priority, std::nullopt);
+    }
+
+    /**
+     * acquire_n with timeout. Empty batch on timeout; resources collected
+     * so far go back to the pool.
+     */
+    Batch try_acquire_n(size_t count, std::chrono::milliseconds timeout,
+                        AcquirePriority priority = AcquirePriority::Normal) {
+        return acquire_batch(count, priority, Clock::now() + timeout);
+    }
+
+    /**
+     * Pending asynchronous acquisition returned by acquire_async().
+     * Usable as a future (get / get_for) or as a coroutine awaitable
+     * (`Handle h = co_await pool.acquire_async();`). A coroutine is resumed
+     * on the pool's executor (see set_executor()), never inline on the
+     * thread whose release completed the request.
+     * Cancelling, timing out or destroying the request before taking the
+     * resource gives it back to the pool. Must not outlive the pool.
+     */
+    class AsyncAcquire {
+    public:
+        AsyncAcquire(AsyncAcquire &&) noexcept = default;
+        AsyncAcquire &operator=(AsyncAcquire &&other) noexcept {
+            if (this != &other) {
+                cancel();
+                pool_ = other.pool_;
+                waiter_ = std::move(other.waiter_);
+            }
+            return *this;
+        }
+        ~AsyncAcquire() { cancel(); }
+
+        bool ready() const {
+            std::lock_guard<std::mutex> lock(waiter_->mutex);
+            return waiter_->state != WaiterState::Pending;
+        }
+
+        /**
+         * Block until a resource is handed over. Empty handle if cancelled.
+         */
+        Handle get() {
+            std::unique_lock<std::mutex> lock(waiter_->mutex);
+            waiter_->ready_cv.wait(lock, [this]() {
+                return waiter_->state != WaiterState::Pending;
+            });
+            return take(lock);
+        }
+
+        /**
+         * Wait up to `timeout`; on timeout the request is cancelled and an
+         * empty handle returned.
+         */
+        Handle get_for(std::chrono::milliseconds timeout) {
+            return get_until(Clock::now() + timeout);
+        }
+
+        // get_for with an absolute deadline
+        Handle get_until(Clock::time_point deadline) {
+            std::unique_lock<std::mutex> lock(waiter_->mutex);
+            waiter_->ready_cv.wait_until(lock, deadline, [this]() {
+                return waiter_->state != WaiterState::Pending;
+            });
+            if (waiter_->state == WaiterState::Pending) {
+                waiter_->state = WaiterState::Cancelled;
+                lock.unlock();
+                pool_->forget_waiter(waiter_);
+                pool_->total_timeouts_.add();
+                return Handle();
+            }
+            return take(lock);
+        }
+
+        /**
+         * Withdraw the request. A suspended coroutine resumes with an empty
+         * handle; a resource already handed over goes back to the pool.
+         */
+        void cancel() {
+            if (!waiter_) {
+                return;  // Moved from
+            }
+            std::unique_lock<std::mutex> lock(waiter_->mutex);
+            switch (waiter_->state) {
+            case WaiterState::Pending: {
+                waiter_->state = WaiterState::Cancelled;
+                auto continuation = std::exchange(waiter_->continuation, nullptr);
+                lock.unlock();
+                pool_->forget_waiter(waiter_);
+                if (continuation) {
+                    pool_->resume_later(continuation);
+                }
+                break;
+            }
+            case WaiterState::Fulfilled:
+                // Never reached the caller: no hold to record or stale
+                // handle to invalidate
+                waiter_->state = WaiterState::Cancelled;
+                lock.unlock();
+                pool_->release_shared(waiter_->index);
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Awaitable interface
+        bool await_ready() const { return ready(); }
+        bool await_suspend(std::coroutine_handle<> continuation) {
+            std::lock_guard<std::mutex> lock(waiter_->mutex);
+            if (waiter_->state != WaiterState::Pending) {
+                return false;  // Completed meanwhile: don't suspend
+            }
+            waiter_->continuation = continuation;
+            return true;
+        }
+        Handle await_resume() {
+            std::unique_lock<std::mutex> lock(waiter_->mutex);
+            return take(lock);
+        }
+
+    private:
+        friend class ResourcePool;
+        AsyncAcquire(ResourcePool *pool, std::shared_ptr<Waiter> waiter)
+            : pool_(pool), waiter_(std::move(waiter)) {}
+
+        Handle take(std::unique_lock<std::mutex> &) {
+            if (waiter_->state != WaiterState::Fulfilled) {
+                return Handle();
+            }
+            waiter_->state = WaiterState::Taken;
+            pool_->note_acquired(waiter_->index, waiter_->created);
+            return Handle(pool_, waiter_->index, pool_->generation_of(waiter_->index));
+        }
+
+        ResourcePool *pool_;
+        std::shared_ptr<Waiter> waiter_;
+    };
+
+    /**
+     * Request a resource without blocking. If none is free, the request
+     * joins the waiter queue and a release hands its resource directly to
+     * the oldest live request of the highest (aged) priority class, ahead
+     * of threads blocked in a non-fair acquire().
+     * A request with a deadline is completed empty and leaves the queue
+     * when the deadline passes, by a pool-owned timer thread started with
+     * the first such request.
+     */
+    AsyncAcquire acquire_async(
+        AcquirePriority priority = AcquirePriority::Normal,
+        std::optional<Clock::time_point> deadline = std::nullopt) {
+        return AsyncAcquire(this, submit(priority, deadline));
     }
 
     // Statistics
     size_t available_count() const {
+        if (free_list_kind_ == FreeListKind::LockFreeStack ||
+            free_list_kind_ == FreeListKind::CpuAffinity) {
+            return shared_.size() - current_usage();  // Approximate under load
+        }
         std::lock_guard<std::mutex> lock(pool_mutex_);
-        return resource_pool_.size();
+        return free_list_.size();
     }
     
-    size_t total_acquisitions() const { return total_acquisitions_.load(); }
-    size_t total_releases() const { return total_releases_.load(); }
+    size_t total_acquisitions() const {
+        return total_acquisitions_.load() + cache_hits(&CacheCounts::acquisitions);
+    }
+    size_t total_releases() const {
+        return total_releases_.load() + cache_hits(&CacheCounts::releases);
+    }
+    size_t total_timeouts() const { return total_timeouts_.load(); }
+    // CpuAffinity only: acquisitions served from the caller's CPU, or not
+    size_t affinity_hits() const { return affinity_hits_.load(); }
+    size_t affinity_misses() const { return affinity_misses_.load(); }
     size_t peak_usage() const { return peak_usage_.load(); }
     size_t current_usage() const { 
-        return total_acquisitions_.load() - total_releases_.load(); 
+        return in_use_.load(); 
     }
+    size_t waiting_count() const { return num_waiters_.load(); }
+    size_t size() const { return shared_.size(); }
 
 private:
+    friend class PoolHandle<Resource>;
+
+    struct Waiter {
+        std::mutex mutex;
+        std::condition_variable ready_cv;
+        WaiterState state{WaiterState::Pending};
+        uint32_t index{0};
+        std::coroutine_handle<> continuation;
+        AcquirePriority priority{AcquirePriority::Normal};
+        std::optional<Clock::time_point> deadline;
+        Clock::time_point created;  // Only set with metrics enabled
+        Clock::time_point queued;   // For priority aging
+        size_t count{1};
+        std::vector<uint32_t> batch;  // Collected so far when count > 1
+        std::atomic<bool> collecting{false};  // Holds part of its batch
+    };
+    static constexpr size_t kPriorityClasses = 3;
+
+    // Per-slot state the holder writes, one cache line per slot so that
+    // threads releasing or caching neighbouring slots don't share lines
+    struct alignas(64) SlotState {
+        // Bumped on every release to tell stale handles apart
+        std::atomic<uint32_t> generation{0};
+        // Parked in some thread's cache. Whoever clears the flag (the
+        // owning thread or a thief) owns the resource.
+        std::atomic<bool> parked{false};
+    };
+
+    // All resources in one contiguous array, plus their slot states
+    struct Storage {
+        std::allocator<Resource> allocator;
+        Resource *resources;
+        size_t count;
+        size_t constructed{0};
+        std::unique_ptr<SlotState[]> slots;
+
+        Storage(size_t pool_size, size_t first_id)
+            : resources(allocator.allocate(pool_size)), count(pool_size),
+              slots(std::make_unique<SlotState[]>(pool_size)) {
+            try {
+                for (; constructed < count; ++constructed) {
+                    std::construct_at(resources + constructed, first_id + constructed);
+                }
+            } catch (...) {
+                destroy();
+                throw;
+            }
+        }
+        ~Storage() { destroy(); }
+
+        void destroy() {
+            std::destroy_n(resources, constructed);
+            allocator.deallocate(resources, count);
+        }
+    };
+
     std::counting_semaphore<> available_resources_;  // C++20 semaphore
-    std::queue<std::shared_ptr<Resource>> resource_pool_;
+    // Free lists hold slot indices into storage_
+    std::shared_ptr<Storage> storage_;
+    std::vector<std::shared_ptr<Resource>> shared_;
+
+    FreeListKind free_list_kind_;
+    // FifoQueue / LifoStack. Release pushes at the back; FIFO takes from the
+    // front, LIFO from the back, so under LIFO the least recently used
+    // (idle) resources collect at the front.
+    std::deque<uint32_t> free_list_;
     mutable std::mutex pool_mutex_;
+    LockFreeIndexStack free_stack_;    // LockFreeStack
+    // CpuAffinity: free indices by the CPU that last released them
+    std::vector<std::unique_ptr<LockFreeIndexStack>> cpu_stacks_;
     
-    // Statistics
-    std::atomic<size_t> total_acquisitions_;
-    std::atomic<size_t> total_releases_;
+    // Statistics. Event counts are striped; in_use_ stays one atomic
+    // because the peak needs an exact current value.
+    StripedCounter total_acquisitions_;
+    StripedCounter total_releases_;
+    StripedCounter total_timeouts_;
+    StripedCounter affinity_hits_;
+    StripedCounter affinity_misses_;
+    std::atomic<size_t> in_use_;  // Exact, unlike acquisitions - releases
     std::atomic<size_t> peak_usage_;
+
+    // Optional instrumentation, see enable_metrics()
+    struct Metrics {
+        LatencyHistogram wait_time;
+        LatencyHistogram hold_time;
+        std::unique_ptr<Clock::time_point[]> held_since;  // Per slot
+        std::atomic<size_t> interval_peak{0};
+
+        size_t history;
+        std::deque<UtilizationSample> samples;
+        std::mutex samples_mutex;
+        std::condition_variable stop_cv;
+        bool stopping{false};
+        std::thread sampler;
+
+        Metrics(size_t pool_size, size_t history)
+            : held_since(std::make_unique<Clock::time_point[]>(pool_size)),
+              history(history) {}
+
+        void stop_sampler() {
+            {
+                std::lock_guard<std::mutex> lock(samples_mutex);
+                stopping = true;
+            }
+            stop_cv.notify_all();
+            if (sampler.joinable()) {
+                sampler.join();
+            }
+        }
+    };
+    std::unique_ptr<Metrics> metrics_;
+
+    // Per-thread caches. A cache entry holds a CacheOwner reference so that
+    // a thread exiting after the pool is destroyed can tell.
+    // Cache hits are counted per thread, by that thread alone, and summed
+    // on read; an exiting thread folds its counts into the owner.
+    struct alignas(64) CacheCounts {
+        std::atomic<size_t> acquisitions{0};
+        std::atomic<size_t> releases{0};
+    };
+    struct CacheOwner {
+        std::mutex mutex;
+        ResourcePool *pool;
+        std::vector<std::shared_ptr<CacheCounts>> live;  // Guarded by mutex
+        size_t retired_acquisitions{0};
+        size_t retired_releases{0};
+    };
+    struct ThreadCacheEntry {
+        std::shared_ptr<CacheOwner> owner;
+        std::vector<uint32_t> indices;
+        std::shared_ptr<CacheCounts> counts;
+    };
+    struct ThreadCache {
+        std::vector<ThreadCacheEntry> entries;
+        ~ThreadCache() {
+            for (auto &entry : entries) {
+                flush(entry);
+                retire(entry);
+            }
+        }
+    };
+
+    std::shared_ptr<CacheOwner> cache_owner_;
+    size_t thread_cache_size_{0};
+    // Threads about to block on the semaphore; nothing is parked meanwhile
+    std::atomic<size_t> blocked_{0};
+
+    // Where suspended acquire_async() coroutines are resumed
+    std::function<void(std::coroutine_handle<>)> executor_;
+    std::once_flag resumer_once_;
+    std::unique_ptr<CoroutineScheduler> resumer_;  // Default executor
+
+    // Queued waiters per priority class, oldest first
+    std::array<std::deque<std::shared_ptr<Waiter>>, kPriorityClasses> waiters_;
+    std::mutex waiters_mutex_;
+    std::atomic<size_t> num_waiters_{0};
+    bool fair_{false};
+    Clock::duration aging_step_{std::chrono::seconds(1)};
+
+    // Completes queued requests at their deadline, see expire_loop()
+    std::once_flag reaper_once_;
+    std::thread reaper_;
+    std::condition_variable reaper_cv_;  // Waits on waiters_mutex_
+    bool reaper_stopping_{false};        // Guarded by waiters_mutex_
+
+    static ThreadCache &thread_cache() {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    static void flush(ThreadCacheEntry &entry) {
+        std::lock_guard<std::mutex> lock(entry.owner->mutex);
+        if (auto *pool = entry.owner->pool) {
+            for (uint32_t index : entry.indices) {
+                if (pool->unpark(index)) {  // Unless stolen meanwhile
+                    pool->return_slot(index);
+                }
+            }
+        }
+        entry.indices.clear();
+    }
+
+    static void retire(ThreadCacheEntry &entry) {
+        std::lock_guard<std::mutex> lock(entry.owner->mutex);
+        auto &owner = *entry.owner;
+        owner.retired_acquisitions += entry.counts->acquisitions.load();
+        owner.retired_releases += entry.counts->releases.load();
+        std::erase(owner.live, entry.counts);
+    }
+
+    static void bump(std::atomic<size_t> &count) {
+        count.store(count.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    }
+
+    size_t cache_hits(std::atomic<size_t> CacheCounts::*field) const {
+        if (!cache_owner_) {
+            return 0;
+        }
+        std::lock_guard<std::mutex> lock(cache_owner_->mutex);
+        size_t total = field == &CacheCounts::acquisitions
+                           ? cache_owner_->retired_acquisitions
+                           : cache_owner_->retired_releases;
+        for (const auto &counts : cache_owner_->live) {
+            total += ((*counts).*field).load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    ThreadCacheEntry &local_entry() {
+        auto &entries = thread_cache().entries;
+        for (auto &entry : entries) {
+            if (entry.owner == cache_owner_) {
+                return entry;
+            }
+        }
+        // First use of this pool on this thread: drop entries of dead pools
+        std::erase_if(entries, [](ThreadCacheEntry &entry) {
+            std::lock_guard<std::mutex> lock(entry.owner->mutex);
+            return entry.owner->pool == nullptr;
+        });
+        auto &entry = entries.emplace_back();
+        entry.owner = cache_owner_;
+        entry.indices.reserve(thread_cache_size_);
+        entry.counts = std::make_shared<CacheCounts>();
+        std::lock_guard<std::mutex> lock(cache_owner_->mutex);
+        cache_owner_->live.push_back(entry.counts);
+        return entry;
+    }
+
+    std::optional<uint32_t> take_cached() {
+        auto &entry = local_entry();
+        auto &cached = entry.indices;
+        while (!cached.empty()) {
+            uint32_t index = cached.back();
+            cached.pop_back();
+            if (unpark(index)) {
+                bump(entry.counts->acquisitions);
+                return index;
+            }
+            // Stolen by a waiting thread
+        }
+        return std::nullopt;
+    }
+
+    // Park a released slot in the calling thread's cache. False if the
+    // cache is full or someone is waiting; the caller then releases it.
+    bool put_cached(uint32_t index) {
+        if (contended()) {
+            return false;
+        }
+        auto &entry = local_entry();
+        auto &cached = entry.indices;
+        if (cached.size() >= thread_cache_size_) {
+            // Drop entries that were stolen since they were parked
+            std::erase_if(cached, [this](uint32_t i) { return !slot(i).parked.load(); });
+            if (cached.size() >= thread_cache_size_) {
+                return false;
+            }
+        }
+        cached.push_back(index);
+        bump(entry.counts->releases);
+        slot(index).parked.store(true);
+        // A waiter that arrived before the store may have scanned past this
+        // slot, so hand it over ourselves. Pairs with the scan in
+        // steal_parked(): one side always sees the other.
+        if (contended() && unpark(index)) {
+            return_slot(index);
+        }
+        return true;
+    }
+
+    bool unpark(uint32_t index) {
+        bool expected = true;
+        return slot(index).parked.compare_exchange_strong(expected, false);
+    }
+
+    // Claim any resource parked in a thread cache, starting the scan at a
+    // per-thread offset so concurrent thieves spread out
+    std::optional<uint32_t> steal_parked() {
+        size_t count = shared_.size();
+        size_t start = detail::stripe_slot() % count;
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t index = static_cast<uint32_t>((start + i) % count);
+            if (slot(index).parked.load() && unpark(index)) {
+                return index;
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool contended() const {
+        return num_waiters_.load() != 0 || blocked_.load() != 0;
+    }
+
+    enum class PermitWait { Permit, Stolen, TimedOut };
+
+    // Take a semaphore permit, waiting until `deadline` if given. With
+    // thread caches on, a thread that would block first steals a parked
+    // resource into `stolen`, and parking stays off while it waits.
+    PermitWait wait_for_permit(std::optional<Clock::time_point> deadline,
+                               uint32_t &stolen) {
+        if (thread_cache_size_ == 0) {
+            if (!deadline) {
+                available_resources_.acquire();
+                return PermitWait::Permit;
+            }
+            return available_resources_.try_acquire_until(*deadline)
+                       ? PermitWait::Permit
+                       : PermitWait::TimedOut;
+        }
+        if (available_resources_.try_acquire()) {
+            return PermitWait::Permit;
+        }
+        blocked_.fetch_add(1);
+        PermitWait result = PermitWait::Permit;
+        if (auto index = steal_parked()) {
+            stolen = *index;
+            result = PermitWait::Stolen;
+        } else if (!deadline) {
+            available_resources_.acquire();
+        } else if (!available_resources_.try_acquire_until(*deadline)) {
+            result = PermitWait::TimedOut;
+        }
+        blocked_.fetch_sub(1);
+        return result;
+    }
+
+    uint32_t acquire_index() {
+        auto start = wait_start();
+        if (thread_cache_size_ != 0) {
+            if (auto cached = take_cached()) {
+                note_acquired(*cached, start);
+                return *cached;
+            }
+        }
+        if (fair_) {
+            return *acquire_queued(AcquirePriority::Normal, std::nullopt);
+        }
+
+        // Wait for available resource (semaphore decrements)
+        uint32_t stolen = 0;
+        if (wait_for_permit(std::nullopt, stolen) == PermitWait::Stolen) {
+            total_acquisitions_.add();  // Already counted in use
+            note_acquired(stolen, start);
+            return stolen;
+        }
+        
+        // A permit guarantees a free slot
+        uint32_t index = take_free();
+        record_acquisition();
+        note_acquired(index, start);
+        return index;
+    }
+
+    void record_acquisition() {
+        total_acquisitions_.add();
+        mark_in_use();
+    }
+
+    void mark_in_use() {
+        size_t current_usage = in_use_.fetch_add(1) + 1;
+        
+        // Update peak usage atomically
+        size_t current_peak = peak_usage_.load();
+        while (current_usage > current_peak && 
+               !peak_usage_.compare_exchange_weak(current_peak, current_usage)) {
+            current_peak = peak_usage_.load();
+        }
+        if (metrics_) {
+            auto &interval_peak = metrics_->interval_peak;
+            size_t peak = interval_peak.load(std::memory_order_relaxed);
+            while (current_usage > peak &&
+                   !interval_peak.compare_exchange_weak(peak, current_usage,
+                                                        std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    Clock::time_point wait_start() const {
+        return metrics_ ? Clock::now() : Clock::time_point{};
+    }
+
+    // The caller now holds `index`: record how long it waited and start
+    // its hold clock
+    void note_acquired(uint32_t index, Clock::time_point wait_start) {
+        if (!metrics_) {
+            return;
+        }
+        auto now = Clock::now();
+        metrics_->wait_time.record(now - wait_start);
+        metrics_->held_since[index] = now;
+    }
+
+    void sample_loop(std::chrono::milliseconds interval) {
+        std::unique_lock<std::mutex> lock(metrics_->samples_mutex);
+        while (!metrics_->stop_cv.wait_for(lock, interval,
+                                           [this]() { return metrics_->stopping; })) {
+            size_t in_use = in_use_.load();
+            // Restart the interval peak from the current level
+            size_t peak = metrics_->interval_peak.exchange(in_use);
+            metrics_->samples.push_back({Clock::now(), in_use, std::max(peak, in_use)});
+            if (metrics_->samples.size() > metrics_->history) {
+                metrics_->samples.pop_front();
+            }
+        }
+    }
+
+    std::optional<uint32_t> try_acquire_index(std::chrono::milliseconds timeout) {
+        auto start = wait_start();
+        if (thread_cache_size_ != 0) {
+            if (auto cached = take_cached()) {
+                note_acquired(*cached, start);
+                return cached;
+            }
+        }
+        if (fair_) {
+            return acquire_queued(AcquirePriority::Normal, Clock::now() + timeout);
+        }
+
+        // Try to acquire with timeout
+        uint32_t stolen = 0;
+        switch (wait_for_permit(Clock::now() + timeout, stolen)) {
+        case PermitWait::TimedOut:
+            total_timeouts_.add();
+            return std::nullopt;
+        case PermitWait::Stolen:
+            total_acquisitions_.add();  // Already counted in use
+            note_acquired(stolen, start);
+            return stolen;
+        case PermitWait::Permit:
+            break;
+        }
+        
+        // A permit guarantees a free slot
+        uint32_t index = take_free();
+        record_acquisition();
+        note_acquired(index, start);
+        return index;
+    }
+
+    void release_index(uint32_t index) {
+        // Only the holder writes its slot's generation, so no RMW is needed
+        auto &generation = slot(index).generation;
+        generation.store(generation.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+        if (metrics_) {
+            metrics_->hold_time.record(Clock::now() - metrics_->held_since[index]);
+        }
+        if (thread_cache_size_ != 0 && put_cached(index)) {
+            return;
+        }
+        release_shared(index);
+    }
+
+    void release_handle(uint32_t index, uint32_t generation) {
+        assert(generation == generation_of(index) && "stale PoolHandle");
+        (void)generation;
+        release_index(index);
+    }
+
+    uint32_t generation_of(uint32_t index) const {
+        return slot(index).generation.load(std::memory_order_relaxed);
+    }
+
+    SlotState &slot(uint32_t index) const { return storage_->slots[index]; }
+
+    Resource *resource_at(uint32_t index) const {
+        return &storage_->resources[index];
+    }
+
+    // Only called while holding a permit, so a free slot exists
+    uint32_t take_free() {
+        if (free_list_kind_ == FreeListKind::CpuAffinity) {
+            return take_free_near(detail::current_cpu());
+        }
+        if (free_list_kind_ == FreeListKind::LockFreeStack) {
+            uint32_t index;
+            // The releaser pushes before posting the permit, so this only
+            // retries while racing other poppers
+            while ((index = free_stack_.pop()) == LockFreeIndexStack::npos) {
+                std::this_thread::yield();
+            }
+            return index;
+        }
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        uint32_t index;
+        if (free_list_kind_ == FreeListKind::LifoStack) {
+            index = free_list_.back();
+            free_list_.pop_back();
+        } else {
+            index = free_list_.front();
+            free_list_.pop_front();
+        }
+        return index;
+    }
+
+    void put_free(uint32_t index) {
+        if (free_list_kind_ == FreeListKind::CpuAffinity) {
+            cpu_stacks_[detail::current_cpu() % cpu_stacks_.size()]->push(index);
+            return;
+        }
+        if (free_list_kind_ == FreeListKind::LockFreeStack) {
+            free_stack_.push(index);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        free_list_.push_back(index);
+    }
+
+    // The caller's CPU's stack first, then the others in order. Never
+    // blocks: a permit is held, so some stack has (or is about to get) a
+    // free index, and the scan repeats only while racing other acquirers.
+    uint32_t take_free_near(size_t cpu) {
+        size_t cpus = cpu_stacks_.size();
+        size_t home = cpu % cpus;
+        uint32_t index = cpu_stacks_[home]->pop();
+        if (index != LockFreeIndexStack::npos) {
+            affinity_hits_.add();
+            return index;
+        }
+        affinity_misses_.add();
+        while (true) {
+            for (size_t i = 1; i <= cpus; ++i) {
+                index = cpu_stacks_[(home + i) % cpus]->pop();
+                if (index != LockFreeIndexStack::npos) {
+                    return index;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    uint32_t index_of(const Resource *resource) const {
+        const Resource *first = storage_->resources;
+        std::less<const Resource *> before;
+        if (before(resource, first) || !before(resource, first + storage_->count)) {
+            throw std::invalid_argument("Resource does not belong to this pool");
+        }
+        return static_cast<uint32_t>(resource - first);
+    }
+
+    void release_shared(uint32_t index) {
+        total_releases_.add();
+        return_slot(index);
+    }
+
+    // Pass on a slot whose release was already counted: to the next
+    // waiter, or back to the free list
+    void return_slot(uint32_t index) {
+        if (num_waiters_.load() != 0 && hand_off(index)) {
+            // Went straight to a waiter: an acquisition, usage unchanged
+            total_acquisitions_.add();
+            return;
+        }
+        release_to_free_list(index);
+        if (num_waiters_.load() != 0) {
+            pump_waiters();
+        }
+    }
+
+    void release_to_free_list(uint32_t index) {
+        put_free(index);
+        
+        in_use_.fetch_sub(1);
+        
+        // Signal that a resource is now available (semaphore increments)
+        available_resources_.release();
+    }
+
+    std::shared_ptr<Waiter> submit(AcquirePriority priority,
+                                   std::optional<Clock::time_point> deadline) {
+        auto waiter = std::make_shared<Waiter>();
+        waiter->priority = priority;
+        waiter->deadline = deadline;
+        waiter->created = wait_start();
+        // Join the queue behind existing waiters rather than overtake them
+        if (num_waiters_.load() == 0 && available_resources_.try_acquire()) {
+            waiter->state = WaiterState::Fulfilled;
+            waiter->index = take_free();
+            record_acquisition();
+            return waiter;
+        }
+        enqueue(waiter);
+        return waiter;
+    }
+
+    void enqueue(const std::shared_ptr<Waiter> &waiter) {
+        waiter->queued = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(waiters_mutex_);
+            waiters_[static_cast<size_t>(waiter->priority)].push_back(waiter);
+            num_waiters_.fetch_add(1);
+        }
+        if (waiter->deadline) {
+            std::call_once(reaper_once_, [this]() {
+                reaper_ = std::thread([this]() { expire_loop(); });
+            });
+            reaper_cv_.notify_one();
+        }
+        // Parking is off from here on; reclaim what is already parked
+        if (cache_owner_) {
+            while (num_waiters_.load() != 0) {
+                auto index = steal_parked();
+                if (!index) {
+                    break;
+                }
+                return_slot(*index);
+            }
+        }
+        // A release that ran before we were queued left its permit behind
+        pump_waiters();
+    }
+
+    Batch acquire_batch(size_t count, AcquirePriority priority,
+                        std::optional<Clock::time_point> deadline) {
+        if (count == 0 || count > shared_.size()) {
+            throw std::invalid_argument("acquire_n count must be in [1, pool size]");
+        }
+        auto waiter = std::make_shared<Waiter>();
+        waiter->priority = priority;
+        waiter->deadline = deadline;
+        waiter->created = wait_start();
+        waiter->count = count;
+        waiter->batch.reserve(count);
+        enqueue(waiter);
+
+        std::unique_lock<std::mutex> lock(waiter->mutex);
+        auto done = [&]() { return waiter->state != WaiterState::Pending; };
+        if (deadline) {
+            waiter->ready_cv.wait_until(lock, *deadline, done);
+        } else {
+            waiter->ready_cv.wait(lock, done);
+        }
+        if (waiter->state != WaiterState::Fulfilled) {
+            if (waiter->state == WaiterState::Pending) {
+                waiter->state = WaiterState::Cancelled;
+                total_timeouts_.add();
+            }
+            auto partial = std::move(waiter->batch);
+            lock.unlock();
+            forget_waiter(waiter);
+            for (uint32_t index : partial) {
+                release_shared(index);
+            }
+            return Batch();
+        }
+        waiter->state = WaiterState::Taken;
+        if (count == 1) {
+            waiter->batch.assign(1, waiter->index);  // Handed off as a single
+        }
+        std::vector<Handle> handles;
+        handles.reserve(count);
+        for (uint32_t index : waiter->batch) {
+            note_acquired(index, waiter->created);
+            handles.push_back(Handle(this, index, generation_of(index)));
+        }
+        return Batch(std::move(handles));
+    }
+
+    // Block in the waiter queue. nullopt if the deadline passed first.
+    std::optional<uint32_t> acquire_queued(AcquirePriority priority,
+                                           std::optional<Clock::time_point> deadline) {
+        AsyncAcquire request(this, submit(priority, deadline));
+        Handle handle = deadline ? request.get_until(*deadline) : request.get();
+        if (!handle) {
+            return std::nullopt;
+        }
+        handle.pool_ = nullptr;  // Ownership passes to the caller's index
+        return handle.index_;
+    }
+
+    // Next waiter to serve; it stays queued. The oldest waiter of each
+    // class competes at its aged priority, ties going to the earlier
+    // arrival. A batch waiter that holds part of its set keeps the head
+    // until it has all of it, so partial sets can't pile up.
+    std::shared_ptr<Waiter> front_waiter() {
+        std::lock_guard<std::mutex> lock(waiters_mutex_);
+        auto now = aging_step_ > Clock::duration::zero() ? Clock::now()
+                                                         : Clock::time_point{};
+        std::shared_ptr<Waiter> best;
+        size_t best_rank = 0;
+        for (size_t p = kPriorityClasses; p-- > 0;) {
+            if (waiters_[p].empty()) {
+                continue;
+            }
+            const auto &head = waiters_[p].front();
+            if (head->collecting.load()) {
+                return head;
+            }
+            size_t rank = p;
+            if (aging_step_ > Clock::duration::zero()) {
+                rank += static_cast<size_t>((now - head->queued) / aging_step_);
+                rank = std::min(rank, kPriorityClasses - 1);
+            }
+            if (!best || rank > best_rank ||
+                (rank == best_rank && head->queued < best->queued)) {
+                best = head;
+                best_rank = rank;
+            }
+        }
+        return best;
+    }
+
+    // Complete a pending waiter empty: its deadline passed. Called with
+    // the waiter's lock held; unlocks it.
+    void expire(const std::shared_ptr<Waiter> &waiter,
+                std::unique_lock<std::mutex> &lock) {
+        waiter->state = WaiterState::Cancelled;
+        total_timeouts_.add();
+        auto continuation = std::exchange(waiter->continuation, nullptr);
+        lock.unlock();
+        forget_waiter(waiter);
+        waiter->ready_cv.notify_all();
+        if (continuation) {
+            resume_later(continuation);
+        }
+    }
+
+    // Timer thread: sleeps until the earliest queued deadline and expires
+    // every request whose deadline has passed. A batch request gives back
+    // its partial set from its own thread once woken.
+    void expire_loop() {
+        std::unique_lock<std::mutex> lock(waiters_mutex_);
+        while (!reaper_stopping_) {
+            auto now = Clock::now();
+            std::vector<std::shared_ptr<Waiter>> expired;
+            std::optional<Clock::time_point> next;
+            for (auto &queue : waiters_) {
+                for (auto &waiter : queue) {
+                    if (!waiter->deadline) {
+                        continue;
+                    }
+                    if (*waiter->deadline <= now) {
+                        expired.push_back(waiter);
+                    } else if (!next || *waiter->deadline < *next) {
+                        next = waiter->deadline;
+                    }
+                }
+            }
+            if (!expired.empty()) {
+                lock.unlock();
+                for (auto &waiter : expired) {
+                    std::unique_lock<std::mutex> waiter_lock(waiter->mutex);
+                    if (waiter->state == WaiterState::Pending) {
+                        expire(waiter, waiter_lock);
+                    } else {
+                        waiter_lock.unlock();
+                        forget_waiter(waiter);
+                    }
+                }
+                lock.lock();
+                continue;
+            }
+            if (next) {
+                reaper_cv_.wait_until(lock, *next);
+            } else {
+                reaper_cv_.wait(lock);
+            }
+        }
+    }
+
+    // Give `index` to the next live waiter. False if there is none.
+    bool hand_off(uint32_t index) {
+        while (auto waiter = front_waiter()) {
+            std::unique_lock<std::mutex> lock(waiter->mutex);
+            if (waiter->state != WaiterState::Pending) {
+                lock.unlock();
+                forget_waiter(waiter);  // Cancelled concurrently
+                continue;
+            }
+            if (waiter->deadline && *waiter->deadline < Clock::now()) {
+                // Too late for this one: complete it empty and move on
+                expire(waiter, lock);
+                continue;
+            }
+            if (waiter->count > 1) {
+                waiter->batch.push_back(index);
+                if (waiter->batch.size() < waiter->count) {
+                    waiter->collecting.store(true);
+                    return true;  // Still at the head, collecting
+                }
+            } else {
+                waiter->index = index;
+            }
+            waiter->state = WaiterState::Fulfilled;
+            auto continuation = std::exchange(waiter->continuation, nullptr);
+            lock.unlock();
+            forget_waiter(waiter);
+            waiter->ready_cv.notify_all();
+            if (continuation) {
+                resume_later(continuation);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Move free permits to queued waiters. Closes the window where a
+    // release saw no waiter just before one was queued.
+    void pump_waiters() {
+        while (num_waiters_.load() != 0 && available_resources_.try_acquire()) {
+            uint32_t index = take_free();
+            // Counted in use before the hand-off, so a waiter releasing it
+            // at once can't take in_use_ below zero
+            mark_in_use();
+            if (!hand_off(index)) {
+                release_to_free_list(index);
+                return;
+            }
+            total_acquisitions_.add();
+        }
+    }
+
+    void resume_later(std::coroutine_handle<> continuation) {
+        if (executor_) {
+            executor_(continuation);
+            return;
+        }
+        std::call_once(resumer_once_, [this]() {
+            resumer_ = std::make_unique<CoroutineScheduler>(1);
+        });
+        resumer_->post(continuation);
+    }
+
+    void forget_waiter(const std::shared_ptr<Waiter> &waiter) {
+        std::lock_guard<std::mutex> lock(waiters_mutex_);
+        auto &queue = waiters_[static_cast<size_t>(waiter->priority)];
+        auto it = std::find(queue.begin(), queue.end(), waiter);
+        if (it != queue.end()) {
+            queue.erase(it);
+            num_waiters_.fetch_sub(1);
+        }
+    }
 };
 
 /**
- * RAII wrapper for automatic resource release
+ * RAII wrapper for automatic resource release.
+ * Built on the pool's move-only Handle, so it works with any pool that
+ * provides acquire_handle/try_acquire_handle.
  */
-template<typename Resource>
+template<typename Resource, typename Pool = ResourcePool<Resource>>
 class ResourceGuard {
 public:
-    ResourceGuard(ResourcePool<Resource>& pool) 
-        : pool_(pool), resource_(pool.acquire()) {}
-    
-    ResourceGuard(ResourcePool<Resource>& pool, std::chrono::milliseconds timeout) 
-        : pool_(pool), resource_(pool.try_acquire(timeout)) {}
+    ResourceGuard(Pool& pool) 
+        : handle_(pool.acquire_handle()) {}
     
-    ~ResourceGuard() {
-        if (resource_) {
-            pool_.release(resource_);
-        }
-    }
+    ResourceGuard(Pool& pool, std::chrono::milliseconds timeout) 
+        : handle_(pool.try_acquire_handle(timeout)) {}
     
-    // Non-copyable but movable
+    // Non-copyable but movable; the handle releases on destruction
     ResourceGuard(const ResourceGuard&) = delete;
     ResourceGuard& operator=(const ResourceGuard&) = delete;
+    ResourceGuard(ResourceGuard&& other) noexcept = default;
     
-    ResourceGuard(ResourceGuard&& other) noexcept 
-        : pool_(other.pool_), resource_(std::move(other.resource_)) {
-        other.resource_ = nullptr;
-    }
-    
-    Resource* operator->() const { return resource_.get(); }
-    Resource& operator*() const { return *resource_; }
+    Resource* operator->() const { return handle_.get(); }
+    Resource& operator*() const { return *handle_; }
     
-    bool valid() const { return resource_ != nullptr; }
+    bool valid() const { return static_cast<bool>(handle_); }
 
 private:
-    ResourcePool<Resource>& pool_;
-    std::shared_ptr<Resource> resource_;
+    typename Pool::Handle handle_;
 };
 
 } // namespace concurrency
\ No newline at end of file
@@ -0,0 +1,217 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "resource_pool.hpp"
+
+namespace concurrency {
+
+/**
+ * Resource pool partitioned into independent ResourcePool shards, so
+ * threads on different cores don't share a semaphore or free list.
+ * A thread's home shard is the one of the CPU it is running on, looked up
+ * on every acquire so a migrated thread follows its new core (on Linux;
+ * elsewhere a per-thread round-robin slot). It only looks at other
+ * shards, in order, when its home shard is empty.
+ * A thread that finds every shard empty sleeps until any shard gets a
+ * release; releases only touch the shared wake-up lock while someone is
+ * asleep.
+ * Resource ids run consecutively across shards, and statistics are sums
+ * over the shards.
+ */
+template<typename Resource>
+class ShardedResourcePool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ShardedResourcePool(
+        size_t pool_size, size_t num_shards = std::thread::hardware_concurrency(),
+        FreeListKind free_list = FreeListKind::LockFreeStack)
+        : pool_size_(pool_size) {
+        if (pool_size == 0) {
+            throw std::invalid_argument("ShardedResourcePool size must be > 0");
+        }
+        num_shards = std::clamp<size_t>(num_shards, 1, pool_size);
+        shards_.reserve(num_shards);
+        size_t first_id = 0;
+        for (size_t i = 0; i < num_shards; ++i) {
+            // Spread the remainder over the first shards
+            size_t size = pool_size / num_shards + (i < pool_size % num_shards);
+            shards_.push_back(std::make_unique<ResourcePool<Resource>>(
+                size, free_list, first_id));
+            first_id += size;
+        }
+    }
+
+    ShardedResourcePool(const ShardedResourcePool &) = delete;
+    ShardedResourcePool &operator=(const ShardedResourcePool &) = delete;
+
+    /**
+     * Move-only handle to a borrowed resource. Remembers its shard, and
+     * wakes a sleeping acquirer when the resource goes back.
+     */
+    class Handle {
+    public:
+        Handle() = default;
+        ~Handle() { reset(); }
+
+        Handle(Handle &&) noexcept = default;
+        Handle &operator=(Handle &&other) noexcept {
+            if (this != &other) {
+                reset();
+                pool_ = std::exchange(other.pool_, nullptr);
+                shard_ = other.shard_;
+                handle_ = std::move(other.handle_);
+            }
+            return *this;
+        }
+
+        Resource *get() const { return handle_.get(); }
+        Resource *operator->() const { return get(); }
+        Resource &operator*() const { return *get(); }
+        explicit operator bool() const { return static_cast<bool>(handle_); }
+
+        size_t shard() const { return shard_; }
+
+        void reset() {
+            if (handle_) {
+                handle_.reset();
+                pool_->notify_release();
+            }
+        }
+
+    private:
+        friend class ShardedResourcePool;
+        Handle(ShardedResourcePool *pool, size_t shard,
+               typename ResourcePool<Resource>::Handle handle)
+            : pool_(pool), shard_(shard), handle_(std::move(handle)) {}
+
+        ShardedResourcePool *pool_ = nullptr;
+        size_t shard_ = 0;
+        typename ResourcePool<Resource>::Handle handle_;
+    };
+
+    /**
+     * Acquire from the home shard, stealing if it is empty (blocking)
+     */
+    Handle acquire_handle() { return acquire_until(std::nullopt); }
+
+    /**
+     * Try to acquire with timeout. Empty handle on timeout.
+     */
+    Handle try_acquire_handle(std::chrono::milliseconds timeout) {
+        return acquire_until(Clock::now() + timeout);
+    }
+
+    /**
+     * Shard the calling thread acquires from first: that of its current CPU
+     */
+    size_t home_shard() const { return detail::current_cpu() % shards_.size(); }
+
+    // Statistics, summed over shards
+    size_t size() const { return pool_size_; }
+    size_t num_shards() const { return shards_.size(); }
+    size_t available_count() const {
+        return sum([](const auto &shard) { return shard.available_count(); });
+    }
+    size_t current_usage() const {
+        return sum([](const auto &shard) { return shard.current_usage(); });
+    }
+    size_t total_acquisitions() const {
+        return sum([](const auto &shard) { return shard.total_acquisitions(); });
+    }
+    size_t total_releases() const {
+        return sum([](const auto &shard) { return shard.total_releases(); });
+    }
+    // Upper bound: shards may have peaked at different times
+    size_t peak_usage() const {
+        return std::min(pool_size_,
+                        sum([](const auto &shard) { return shard.peak_usage(); }));
+    }
+    size_t total_steals() const { return total_steals_.load(); }
+    // try_acquire_handle() calls that timed out; shards never count probes
+    size_t total_timeouts() const { return total_timeouts_.load(); }
+
+    const ResourcePool<Resource> &shard(size_t i) const { return *shards_[i]; }
+
+private:
+    size_t pool_size_;
+    std::vector<std::unique_ptr<ResourcePool<Resource>>> shards_;
+    std::atomic<size_t> total_steals_{0};
+    std::atomic<size_t> total_timeouts_{0};
+
+    // Wake-up for threads that found every shard empty
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<size_t> sleepers_{0};
+
+    template<typename Fn>
+    size_t sum(Fn fn) const {
+        size_t total = 0;
+        for (const auto &shard : shards_) {
+            total += fn(*shard);
+        }
+        return total;
+    }
+
+    // One non-blocking pass: home shard first, then the others in order.
+    // Misses aren't counted as timeouts by the shards.
+    Handle try_take() {
+        size_t home = home_shard();
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            size_t shard = (home + i) % shards_.size();
+            auto handle = shards_[shard]->try_take_handle();
+            if (handle) {
+                if (i != 0) {
+                    total_steals_.fetch_add(1);
+                }
+                return Handle(this, shard, std::move(handle));
+            }
+        }
+        return Handle();
+    }
+
+    Handle acquire_until(std::optional<Clock::time_point> deadline) {
+        if (auto handle = try_take()) {
+            return handle;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleepers_.fetch_add(1);
+        while (true) {
+            // A release either lands before this pass or sees sleepers_ > 0
+            // and notifies under sleep_mutex_, which we hold until waiting
+            if (auto handle = try_take()) {
+                sleepers_.fetch_sub(1);
+                return handle;
+            }
+            if (!deadline) {
+                sleep_cv_.wait(lock);
+            } else if (sleep_cv_.wait_until(lock, *deadline) ==
+                       std::cv_status::timeout) {
+                auto handle = try_take();
+                sleepers_.fetch_sub(1);
+                if (!handle) {
+                    total_timeouts_.fetch_add(1);
+                }
+                return handle;
+            }
+        }
+    }
+
+    void notify_release() {
+        if (sleepers_.load() != 0) {
+            { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+            sleep_cv_.notify_one();
+        }
+    }
+};
+
+} // namespace concurrency
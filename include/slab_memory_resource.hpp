@@ -0,0 +1,265 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+namespace concurrency {
+
+/**
+ * Size-class slab allocator as a std::pmr::memory_resource, for pooling
+ * small fixed-size objects (queue, cache and buffer nodes) without
+ * contending on malloc.
+ * Requests up to kMaxBlock bytes are rounded up to a power-of-two class and
+ * carved from slabs taken from `upstream`. Every thread keeps a free list
+ * per class and only touches the shared depot, a mutex-guarded free list
+ * per class, to move `batch` blocks at a time. Larger or over-aligned
+ * requests go straight to upstream.
+ * Blocks may be freed on any thread. Slabs go back to upstream only when
+ * the resource is destroyed.
+ */
+class SlabMemoryResource : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kMinBlock = 16;
+    static constexpr size_t kMaxBlock = 1024;
+    static constexpr size_t kNumClasses = 7;  // 16, 32, ..., 1024
+
+    explicit SlabMemoryResource(
+        size_t slab_size = 64 * 1024, size_t batch = 32,
+        std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+        : slab_size_(slab_size), batch_(batch), upstream_(upstream),
+          owner_(std::make_shared<Owner>()) {
+        if (slab_size_ < kMaxBlock || batch_ == 0 || upstream_ == nullptr) {
+            throw std::invalid_argument("SlabMemoryResource needs slab_size >= "
+                                        "kMaxBlock, batch > 0 and an upstream");
+        }
+        owner_->resource = this;
+    }
+
+    ~SlabMemoryResource() override {
+        {
+            // Thread caches that outlive us just drop their blocks
+            std::lock_guard<std::mutex> lock(owner_->mutex);
+            owner_->resource = nullptr;
+        }
+        for (void *slab : slabs_) {
+            upstream_->deallocate(slab, slab_size_, alignof(std::max_align_t));
+        }
+    }
+
+    SlabMemoryResource(const SlabMemoryResource &) = delete;
+    SlabMemoryResource &operator=(const SlabMemoryResource &) = delete;
+
+    /**
+     * Return the calling thread's cached blocks to the shared depot
+     */
+    void flush_thread_cache() {
+        for (auto &entry : thread_cache().entries) {
+            if (entry.owner == owner_) {
+                flush(entry);
+            }
+        }
+    }
+
+    // Statistics
+    size_t slab_count() const {
+        std::lock_guard<std::mutex> lock(slabs_mutex_);
+        return slabs_.size();
+    }
+    size_t slab_size() const { return slab_size_; }
+    std::pmr::memory_resource *upstream_resource() const { return upstream_; }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        if (!pooled(bytes, alignment)) {
+            return upstream_->allocate(bytes, alignment);
+        }
+        size_t size_class = class_of(bytes, alignment);
+        auto &cache = local_entry().classes[size_class];
+        if (cache.head == nullptr) {
+            refill(size_class, cache);
+        }
+        FreeBlock *block = cache.head;
+        cache.head = block->next;
+        --cache.count;
+        return block;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        if (!pooled(bytes, alignment)) {
+            upstream_->deallocate(p, bytes, alignment);
+            return;
+        }
+        size_t size_class = class_of(bytes, alignment);
+        auto &cache = local_entry().classes[size_class];
+        cache.head = ::new (p) FreeBlock{cache.head};
+        // Keep one batch in hand; give the rest back so threads that only
+        // free (consumers) don't hoard what producers allocate
+        if (++cache.count >= 2 * batch_) {
+            give_back(size_class, cache, batch_);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    struct alignas(64) Depot {
+        std::mutex mutex;
+        FreeBlock *head{nullptr};
+        size_t count{0};
+    };
+
+    // Per-thread caches, keyed by an Owner block that outlives the resource
+    // so a thread exiting after it can tell not to touch the depot.
+    struct Owner {
+        std::mutex mutex;
+        SlabMemoryResource *resource{nullptr};
+    };
+    struct ClassCache {
+        FreeBlock *head{nullptr};
+        size_t count{0};
+    };
+    struct ThreadCacheEntry {
+        std::shared_ptr<Owner> owner;
+        std::array<ClassCache, kNumClasses> classes{};
+    };
+    struct ThreadCache {
+        std::vector<ThreadCacheEntry> entries;
+        ~ThreadCache() {
+            for (auto &entry : entries) {
+                flush(entry);
+            }
+        }
+    };
+
+    size_t slab_size_;
+    size_t batch_;
+    std::pmr::memory_resource *upstream_;
+    std::shared_ptr<Owner> owner_;
+    std::array<Depot, kNumClasses> depots_;
+    std::vector<void *> slabs_;
+    mutable std::mutex slabs_mutex_;
+
+    static constexpr bool pooled(size_t bytes, size_t alignment) {
+        return bytes <= kMaxBlock && alignment <= alignof(std::max_align_t);
+    }
+
+    static constexpr size_t class_of(size_t bytes, size_t alignment) {
+        size_t size = std::bit_ceil(std::max({bytes, alignment, kMinBlock}));
+        return std::countr_zero(size) - std::countr_zero(kMinBlock);
+    }
+
+    static constexpr size_t block_size(size_t size_class) {
+        return kMinBlock << size_class;
+    }
+
+    static ThreadCache &thread_cache() {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    static void flush(ThreadCacheEntry &entry) {
+        std::lock_guard<std::mutex> lock(entry.owner->mutex);
+        if (entry.owner->resource) {
+            for (size_t c = 0; c < kNumClasses; ++c) {
+                entry.owner->resource->give_back(c, entry.classes[c],
+                                                 entry.classes[c].count);
+            }
+        }
+        entry.classes = {};
+    }
+
+    ThreadCacheEntry &local_entry() {
+        auto &entries = thread_cache().entries;
+        for (auto &entry : entries) {
+            if (entry.owner == owner_) {
+                return entry;
+            }
+        }
+        // First use on this thread: drop entries of dead resources
+        std::erase_if(entries, [](ThreadCacheEntry &entry) {
+            std::lock_guard<std::mutex> lock(entry.owner->mutex);
+            return entry.owner->resource == nullptr;
+        });
+        auto &entry = entries.emplace_back();
+        entry.owner = owner_;
+        return entry;
+    }
+
+    // Move up to one batch from the depot into an empty thread cache,
+    // carving a new slab if the depot is empty
+    void refill(size_t size_class, ClassCache &cache) {
+        auto &depot = depots_[size_class];
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        if (depot.head == nullptr) {
+            carve_slab(size_class, depot);
+        }
+        size_t n = std::min(batch_, depot.count);
+        FreeBlock *first = depot.head;
+        FreeBlock *last = first;
+        for (size_t i = 1; i < n; ++i) {
+            last = last->next;
+        }
+        depot.head = last->next;
+        depot.count -= n;
+        last->next = nullptr;
+        cache.head = first;
+        cache.count = n;
+    }
+
+    // Move the first `n` blocks of a thread cache to the depot
+    void give_back(size_t size_class, ClassCache &cache, size_t n) {
+        if (n == 0) {
+            return;
+        }
+        FreeBlock *first = cache.head;
+        FreeBlock *last = first;
+        for (size_t i = 1; i < n; ++i) {
+            last = last->next;
+        }
+        cache.head = last->next;
+        cache.count -= n;
+
+        auto &depot = depots_[size_class];
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        last->next = depot.head;
+        depot.head = first;
+        depot.count += n;
+    }
+
+    // Caller holds depot.mutex
+    void carve_slab(size_t size_class, Depot &depot) {
+        auto *slab = static_cast<std::byte *>(
+            upstream_->allocate(slab_size_, alignof(std::max_align_t)));
+        {
+            std::lock_guard<std::mutex> lock(slabs_mutex_);
+            try {
+                slabs_.push_back(slab);
+            } catch (...) {
+                upstream_->deallocate(slab, slab_size_, alignof(std::max_align_t));
+                throw;
+            }
+        }
+        size_t size = block_size(size_class);
+        size_t blocks = slab_size_ / size;
+        // Link back to front so blocks are handed out in address order
+        for (size_t i = blocks; i-- > 0;) {
+            depot.head = ::new (slab + i * size) FreeBlock{depot.head};
+        }
+        depot.count += blocks;
+    }
+};
+
+} // namespace concurrency
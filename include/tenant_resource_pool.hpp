@@ -0,0 +1,313 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "resource_pool.hpp"
+
+namespace concurrency {
+
+/**
+ * ResourcePool shared by several tenants under per-tenant quotas.
+ * Each tenant has a `reserved` share and a `max` it can never exceed.
+ * A tenant above its reservation borrows any free unit: the unreserved
+ * capacity, or other tenants' idle reservations. Borrowed units are not
+ * preempted; a tenant that asks for its reservation while it is lent out
+ * claims the next units released, and borrowers are refused until its
+ * claim is met.
+ * Admission is a couple of CAS loops on per-tenant and pool-wide counters,
+ * with no lock. Only a tenant that has to wait sleeps, on its own condition
+ * variable; a release wakes one waiter, a reclaiming owner first. A
+ * tenant's usage is counted before it takes a resource and after it
+ * returns one, so an admitted tenant always finds a resource in the pool.
+ */
+template<typename Resource>
+class TenantResourcePool {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TenantId = size_t;
+
+    explicit TenantResourcePool(size_t pool_size,
+                                FreeListKind free_list = FreeListKind::FifoQueue)
+        : pool_(pool_size, free_list), pool_size_(pool_size),
+          unreserved_(pool_size) {}
+
+    TenantResourcePool(const TenantResourcePool &) = delete;
+    TenantResourcePool &operator=(const TenantResourcePool &) = delete;
+
+    /**
+     * Register a tenant. Throws std::invalid_argument if reserved > max,
+     * max is 0 or the reservations would exceed the pool size.
+     * Must be called before the pool is shared between threads.
+     */
+    TenantId add_tenant(size_t reserved, size_t max) {
+        if (max == 0 || reserved > max || reserved > unreserved_) {
+            throw std::invalid_argument(
+                "tenant quota needs 0 < max, reserved <= max and "
+                "reservations within the pool size");
+        }
+        unreserved_ -= reserved;
+        tenants_.push_back(std::make_unique<Tenant>(reserved, max));
+        return tenants_.size() - 1;
+    }
+
+    /**
+     * Move-only handle; returns the resource and the tenant's quota on
+     * destruction
+     */
+    class Handle {
+    public:
+        Handle() = default;
+        ~Handle() { reset(); }
+
+        Handle(Handle &&) noexcept = default;
+        Handle &operator=(Handle &&other) noexcept {
+            if (this != &other) {
+                reset();
+                pool_ = std::exchange(other.pool_, nullptr);
+                tenant_ = other.tenant_;
+                handle_ = std::move(other.handle_);
+            }
+            return *this;
+        }
+
+        Resource *get() const { return handle_.get(); }
+        Resource *operator->() const { return get(); }
+        Resource &operator*() const { return *get(); }
+        explicit operator bool() const { return static_cast<bool>(handle_); }
+
+        TenantId tenant() const { return tenant_; }
+
+        void reset() {
+            if (handle_) {
+                handle_.reset();  // Resource first, then the quota
+                pool_->release_quota(tenant_);
+            }
+        }
+
+    private:
+        friend class TenantResourcePool;
+        Handle(TenantResourcePool *pool, TenantId tenant,
+               typename ResourcePool<Resource>::Handle handle)
+            : pool_(pool), tenant_(tenant), handle_(std::move(handle)) {}
+
+        TenantResourcePool *pool_ = nullptr;
+        TenantId tenant_ = 0;
+        typename ResourcePool<Resource>::Handle handle_;
+    };
+
+    /**
+     * Acquire for `tenant`, waiting if it is at its max or no unit is free
+     * to it (blocking)
+     */
+    Handle acquire(TenantId tenant) { return acquire_until(tenant, std::nullopt); }
+
+    /**
+     * Try to acquire for `tenant` with timeout. Empty handle on timeout.
+     */
+    Handle try_acquire(TenantId tenant, std::chrono::milliseconds timeout) {
+        return acquire_until(tenant, Clock::now() + timeout);
+    }
+
+    // Statistics
+    size_t in_use(TenantId tenant) const { return at(tenant).in_use.load(); }
+    size_t borrowed(TenantId tenant) const {
+        const Tenant &t = at(tenant);
+        size_t used = t.in_use.load();
+        return used > t.reserved ? used - t.reserved : 0;
+    }
+    size_t rejections(TenantId tenant) const { return at(tenant).rejections.load(); }
+    size_t reserved(TenantId tenant) const { return at(tenant).reserved; }
+    size_t max(TenantId tenant) const { return at(tenant).max; }
+    // Capacity nobody has reserved
+    size_t shared_capacity() const { return unreserved_; }
+    // Units held above their tenant's reservation, in all
+    size_t borrowed_total() const { return borrowed_.load(); }
+    // Borrowed units beyond the unreserved capacity: idle reservations lent out
+    size_t lent() const {
+        size_t borrowed = borrowed_.load();
+        return borrowed > unreserved_ ? borrowed - unreserved_ : 0;
+    }
+    // Reserved units that waiting owners are reclaiming
+    size_t owed() const { return owed_.load(); }
+    size_t num_tenants() const { return tenants_.size(); }
+    const ResourcePool<Resource> &pool() const { return pool_; }
+
+private:
+    struct alignas(64) Tenant {
+        Tenant(size_t reserved, size_t max) : reserved(reserved), max(max) {}
+
+        const size_t reserved;
+        const size_t max;
+        std::atomic<size_t> in_use{0};
+        std::atomic<size_t> rejections{0};  // Admission attempts refused
+
+        // Guarded by sleep_mutex_
+        std::condition_variable wake_cv;
+        size_t sleepers{0};
+        size_t owed{0};  // Sleepers counted in owed_, at most the shortfall
+    };
+
+    ResourcePool<Resource> pool_;
+    std::vector<std::unique_ptr<Tenant>> tenants_;
+    size_t pool_size_;
+    size_t unreserved_;  // Pool size minus all reservations
+    std::atomic<size_t> total_in_use_{0};
+    std::atomic<size_t> borrowed_{0};
+    std::atomic<size_t> owed_{0};  // Off limits to borrowers
+
+    // Wake-up for waiting tenants
+    std::mutex sleep_mutex_;
+    std::atomic<size_t> sleepers_{0};
+    size_t wake_cursor_{0};  // Round robin over tenants, under sleep_mutex_
+
+    Tenant &at(TenantId tenant) const {
+        if (tenant >= tenants_.size()) {
+            throw std::invalid_argument("unknown tenant");
+        }
+        return *tenants_[tenant];
+    }
+
+    // Count one more unit for the tenant. Below its reservation it may
+    // take any free unit; above it (borrowing) only units no waiting owner
+    // is reclaiming.
+    bool try_admit(Tenant &tenant) {
+        size_t used = tenant.in_use.load();
+        while (true) {
+            if (used >= tenant.max) {
+                return false;
+            }
+            bool borrowing = used >= tenant.reserved;
+            size_t total = total_in_use_.load();
+            do {
+                size_t limit = pool_size_;
+                if (borrowing) {
+                    limit -= std::min(owed_.load(), pool_size_);
+                }
+                if (total >= limit) {
+                    return false;
+                }
+            } while (!total_in_use_.compare_exchange_weak(total, total + 1));
+            if (tenant.in_use.compare_exchange_strong(used, used + 1)) {
+                if (borrowing) {
+                    borrowed_.fetch_add(1);
+                }
+                return true;
+            }
+            // Lost a race on the tenant's count: give the unit back, retry
+            total_in_use_.fetch_sub(1);
+        }
+    }
+
+    void release_quota(TenantId id) {
+        Tenant &tenant = *tenants_[id];
+        if (tenant.in_use.fetch_sub(1) > tenant.reserved) {
+            borrowed_.fetch_sub(1);
+        }
+        total_in_use_.fetch_sub(1);
+        if (sleepers_.load() != 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            wake_one(id);
+        }
+    }
+
+    // Wake a single waiter that can use a freed unit: an owner reclaiming
+    // its reservation, else a waiter of `released` (it may have been at
+    // its max), else the next tenant that can still grow. Holds
+    // sleep_mutex_.
+    void wake_one(TenantId released) {
+        size_t count = tenants_.size();
+        for (size_t i = 0; i < count; ++i) {
+            Tenant &tenant = *tenants_[(wake_cursor_ + i) % count];
+            if (tenant.owed != 0) {
+                wake_cursor_ = (wake_cursor_ + i + 1) % count;
+                tenant.wake_cv.notify_one();
+                return;
+            }
+        }
+        if (tenants_[released]->sleepers != 0) {
+            tenants_[released]->wake_cv.notify_one();
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            Tenant &tenant = *tenants_[(wake_cursor_ + i) % count];
+            if (tenant.sleepers != 0 && tenant.in_use.load() < tenant.max) {
+                wake_cursor_ = (wake_cursor_ + i + 1) % count;
+                tenant.wake_cv.notify_one();
+                return;
+            }
+        }
+    }
+
+    Handle admitted(TenantId id) {
+        // Admission guarantees a free resource (modulo releases in flight)
+        return Handle(this, id, pool_.acquire_handle());
+    }
+
+    Handle acquire_until(TenantId id, std::optional<Clock::time_point> deadline) {
+        Tenant &tenant = at(id);
+        if (try_admit(tenant)) {
+            return admitted(id);
+        }
+        tenant.rejections.fetch_add(1);
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleepers_.fetch_add(1);
+        ++tenant.sleepers;
+        bool owed = false;  // Whether this waiter counts in owed_
+
+        // Claim a reserved unit while the tenant is below its reservation,
+        // one claim per missing unit
+        auto update_claim = [&]() {
+            size_t used = tenant.in_use.load();
+            size_t shortfall = used < tenant.reserved ? tenant.reserved - used : 0;
+            if (!owed && tenant.owed < shortfall) {
+                owed = true;
+                ++tenant.owed;
+                owed_.fetch_add(1);
+            } else if (owed && tenant.owed > shortfall) {
+                owed = false;
+                --tenant.owed;
+                owed_.fetch_sub(1);
+            }
+        };
+        // Stop waiting. A dropped claim or a unit left over may let someone
+        // else in, so pass the wake-up on.
+        auto leave = [&](bool ok) {
+            sleepers_.fetch_sub(1);
+            --tenant.sleepers;
+            if (owed) {
+                --tenant.owed;
+                owed_.fetch_sub(1);
+            }
+            if (sleepers_.load() != 0 && total_in_use_.load() < pool_size_) {
+                wake_one(id);
+            }
+            lock.unlock();
+            return ok ? admitted(id) : Handle();
+        };
+
+        while (true) {
+            // A release either lands before this check or sees sleepers_
+            // and wakes us under sleep_mutex_, which we hold until waiting
+            update_claim();
+            if (try_admit(tenant)) {
+                return leave(true);
+            }
+            if (!deadline) {
+                tenant.wake_cv.wait(lock);
+            } else if (tenant.wake_cv.wait_until(lock, *deadline) ==
+                       std::cv_status::timeout) {
+                update_claim();
+                return leave(try_admit(tenant));
+            }
+        }
+    }
+};
+
+} // namespace concurrency
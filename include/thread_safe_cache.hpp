@@ -1,9 +1,11 @@
 #ifndef THREAD_SAFE_CACHE
 #define THREAD_SAFE_CACHE
 
+#include <cassert>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
 #include <unordered_map>
@@ -13,10 +15,14 @@ namespace concurrency {
 /**
  * A thread-safe LRU cache with configurable capacity.
  * Should support concurrent reads and exclusive writes.
+ * List nodes and the index come from `Allocator`; see pmr::ThreadSafeCache.
  */
-template <typename Key, typename Value> class ThreadSafeCache {
+template <typename Key, typename Value,
+          typename Allocator = std::allocator<std::pair<const Key, Value>>>
+class ThreadSafeCache {
 public:
-    explicit ThreadSafeCache(size_t capacity) : capacity_(capacity) {}
+    explicit ThreadSafeCache(size_t capacity, const Allocator &alloc = Allocator())
+        : capacity_(capacity), alloc_(alloc), cache_(MapAllocator(alloc)) {}
     ~ThreadSafeCache() = default; // hello
 
     ThreadSafeCache(const ThreadSafeCache &) = delete;
@@ -79,7 +85,7 @@ public:
             node->value_ = value;
             move_to_front(node);
         } else {
-            node = std::make_shared<Node>(key, value);
+            node = std::allocate_shared<Node>(NodeAllocator(alloc_), key, value);
             cache_.insert(std::make_pair(key, node));
             assert(node->next_ == nullptr);
             node->next_ = head_;
@@ -163,6 +169,7 @@ public:
 private:
     mutable std::mutex mutex_;
     size_t capacity_;
+    Allocator alloc_;
 
     // LRU implementation: doubly linked list + hash map
     struct Node {
@@ -173,8 +180,15 @@ private:
             : key_(key), value_(value), prev_(nullptr), next_(nullptr) {}
     };
 
+    template <typename U>
+    using Rebind = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+    using NodeAllocator = Rebind<Node>;
+    using MapAllocator = Rebind<std::pair<const Key, std::shared_ptr<Node>>>;
+
     std::shared_ptr<Node> head_, tail_; // Dummy nodes
-    std::unordered_map<Key, std::shared_ptr<Node>> cache_;
+    std::unordered_map<Key, std::shared_ptr<Node>, std::hash<Key>,
+                       std::equal_to<Key>, MapAllocator>
+        cache_;
 
     void move_to_front(std::shared_ptr<Node> node) {
         if (node == head_)
@@ -195,5 +209,11 @@ private:
     }
 };
 
+namespace pmr {
+template <typename Key, typename Value>
+using ThreadSafeCache = concurrency::ThreadSafeCache<
+    Key, Value, std::pmr::polymorphic_allocator<std::pair<const Key, Value>>>;
+} // namespace pmr
+
 } // namespace concurrency
 #endif
\ No newline at end of file
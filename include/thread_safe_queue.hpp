@@ -2,6 +2,9 @@
 #define THREAD_SAFE_QUEUE
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
 #include <queue>
@@ -12,11 +15,13 @@ namespace concurrency {
 /**
  * A thread-safe queue implementation.
  * Should support multiple producers and consumers safely.
+ * Storage comes from `Allocator`; see pmr::ThreadSafeQueue.
  */
-template<typename T>
+template<typename T, typename Allocator = std::allocator<T>>
 class ThreadSafeQueue {
 public:
     ThreadSafeQueue() = default;
+    explicit ThreadSafeQueue(const Allocator &alloc) : mQueue(alloc) {}
     ~ThreadSafeQueue() = default;
     
     // Non-copyable, non-movable for simplicity
@@ -98,10 +103,16 @@ public:
 private:
     // TODO: Implement with proper synchronization primitives
     mutable std::mutex mMutex;
-    std::queue<T> mQueue;
+    std::queue<T, std::deque<T, Allocator>> mQueue;
     std::condition_variable mCondVar;
     std::atomic<bool> mShutdown = false;
 };
 
+namespace pmr {
+template<typename T>
+using ThreadSafeQueue =
+    concurrency::ThreadSafeQueue<T, std::pmr::polymorphic_allocator<T>>;
+} // namespace pmr
+
 } // namespace concurrency
 #endif
\ No newline at end of file
@@ -1,17 +1,25 @@
 #include "dining_philosophers.hpp"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <random>
+#include <stdexcept>
 #include <thread>
 
 namespace concurrency {
 
-DiningPhilosophers::DiningPhilosophers(int num_philosophers)
-    : num_philosophers_(num_philosophers), forks_(num_philosophers),
-      eat_counts_(num_philosophers), states_(num_philosophers) {
-    threads_.reserve(num_philosophers);
+DiningPhilosophers::DiningPhilosophers(int num_philosophers, Strategy strategy)
+    : DiningPhilosophers(make_fork_strategy(strategy, num_philosophers)) {}
+
+DiningPhilosophers::DiningPhilosophers(std::unique_ptr<ForkStrategy> strategy)
+    : num_philosophers_(strategy ? strategy->num_philosophers() : 0),
+      strategy_(std::move(strategy)), eat_counts_(num_philosophers_),
+      states_(num_philosophers_) {
+    if (num_philosophers_ < 2) {
+        throw std::invalid_argument("DiningPhilosophers needs at least two philosophers");
+    }
+    threads_.reserve(num_philosophers_);
     running_.store(false);
-    // TODO: Initialize forks and other data structures
 }
 
 DiningPhilosophers::~DiningPhilosophers() {
@@ -20,6 +28,14 @@ DiningPhilosophers::~DiningPhilosophers() {
     }
 }
 
+void DiningPhilosophers::set_timing(Timing timing) {
+    if (timing.think_min > timing.think_max || timing.eat_min > timing.eat_max ||
+        timing.think_min.count() < 0 || timing.eat_min.count() < 0) {
+        throw std::invalid_argument("DiningPhilosophers timing needs 0 <= min <= max");
+    }
+    timing_ = timing;
+}
+
 void DiningPhilosophers::start_dining() {
     if (running_.exchange(true)) {
         return; // Already running
@@ -31,6 +47,8 @@ void DiningPhilosophers::start_dining() {
         threads_.emplace_back(&DiningPhilosophers::philosopher_routine, this,
                               i);
     }
+    start_gate_.store(true);
+    start_gate_.notify_all();
 }
 
 void DiningPhilosophers::stop_dining() {
@@ -43,6 +61,7 @@ void DiningPhilosophers::stop_dining() {
         }
     }
     threads_.clear();
+    start_gate_.store(false);
 }
 
 std::vector<int> DiningPhilosophers::get_eat_counts() const {
@@ -53,56 +72,47 @@ std::vector<int> DiningPhilosophers::get_eat_counts() const {
 }
 
 bool DiningPhilosophers::is_deadlocked() const {
-    // TODO: Implement deadlock detection
-    State state = states_[0].load();
-    if ((state == State::Eat) || (state == State::Think))
-        return false;
-    bool res =
-        std::all_of(states_.begin(), states_.end(),
-                    [state](auto const &s) { return s.load() == state; });
-    return res;
+    // A confirmed cycle in the wait-for graph through this table's forks.
+    // Strategies that don't block on mutexes can't deadlock this way.
+    auto report = LockMonitor::global().scan();
+    return std::any_of(report.cycles.begin(), report.cycles.end(), [this](const auto &cycle) {
+        return std::any_of(cycle.begin(), cycle.end(), [this](const LockWait &wait) {
+            return strategy_->uses_lock(wait.lock);
+        });
+    });
 }
 
 void DiningPhilosophers::philosopher_routine(int philosopher_id) {
     std::mt19937 gen(philosopher_id + std::time(nullptr));
-    std::uniform_int_distribution<> think_time(10, 100);
-    std::uniform_int_distribution<> eat_time(10, 50);
-
-    auto minfork = [](int id, int total) {
-        return std::min(id, (id + 1) % total);
-    };
-    auto maxfork = [](int id, int total) {
-        return std::max(id, (id + 1) % total);
-    };
+    std::uniform_int_distribution<int64_t> think_time(timing_.think_min.count(),
+                                                      timing_.think_max.count());
+    std::uniform_int_distribution<int64_t> eat_time(timing_.eat_min.count(),
+                                                    timing_.eat_max.count());
+    start_gate_.wait(false);
+
     while (running_.load()) {
         // Think
         states_[philosopher_id].store(State::Think);
-        std::this_thread::sleep_for(std::chrono::milliseconds(think_time(gen)));
-
-        {
-            states_[philosopher_id].store(State::WaitLeft);
-
-            output(philosopher_id, "wait for left fork");
-            std::lock_guard<std::mutex> left_fork(
-                forks_[minfork(philosopher_id, num_philosophers_)]);
-            states_[philosopher_id].store(State::WaitRight);
+        std::this_thread::sleep_for(std::chrono::microseconds(think_time(gen)));
+
+        auto hungry_since = std::chrono::steady_clock::now();
+        states_[philosopher_id].store(State::WaitLeft);
+        output(philosopher_id, "wait for forks");
+        strategy_->pick_up(philosopher_id, states_[philosopher_id]);
+        hunger_.record(std::chrono::steady_clock::now() - hungry_since);
+        states_[philosopher_id].store(State::Eat);
+        std::this_thread::sleep_for(std::chrono::microseconds(eat_time(gen)));
+        eat_counts_[philosopher_id].fetch_add(1);
+        strategy_->put_down(philosopher_id);
 
-            output(philosopher_id, "wait for right fork");
-            std::lock_guard<std::mutex> right_fork(
-                forks_[maxfork(philosopher_id, num_philosophers_)]);
-            states_[philosopher_id].store(State::Eat);
-
-            std::this_thread::sleep_for(
-                std::chrono::milliseconds(eat_time(gen)));
-            eat_counts_[philosopher_id].fetch_add(1);
-        }
         output(philosopher_id, "finished eating");
     }
 }
+
 void DiningPhilosophers::output(int id, std::string const &msg) {
     return;
     // std::lock_guard<std::mutex> lock(output_mutex_);
     // std::cout << id << " : " << msg << std::endl;
 }
 
-} // namespace concurrency
\ No newline at end of file
+} // namespace concurrency
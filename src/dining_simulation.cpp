@@ -0,0 +1,321 @@
+#include "dining_simulation.hpp"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace concurrency {
+
+double SimulationResult::jain_fairness() const {
+    double sum = 0;
+    double sum_squares = 0;
+    for (uint64_t count : eat_counts) {
+        sum += static_cast<double>(count);
+        sum_squares += static_cast<double>(count) * static_cast<double>(count);
+    }
+    return sum_squares > 0 ? sum * sum / (eat_counts.size() * sum_squares) : 0.0;
+}
+
+DiningSimulation::DiningSimulation(int num_philosophers, ForkStrategyKind strategy,
+                                   Timing timing, uint64_t seed)
+    : num_philosophers_(num_philosophers), strategy_(strategy), timing_(timing),
+      gen_(seed), philosophers_(num_philosophers), holders_(num_philosophers, -1),
+      waiters_(num_philosophers), free_seats_(num_philosophers - 1) {
+    if (num_philosophers < 2) {
+        throw std::invalid_argument("DiningSimulation needs at least two philosophers");
+    }
+    if (timing.think_min > timing.think_max || timing.eat_min > timing.eat_max ||
+        timing.think_min.count() < 0 || timing.eat_min.count() < 0) {
+        throw std::invalid_argument("DiningSimulation timing needs 0 <= min <= max");
+    }
+    if (strategy_ == ForkStrategyKind::ChandyMisra) {
+        cm_forks_.resize(num_philosophers);
+        for (int f = 0; f < num_philosophers; ++f) {
+            cm_forks_[f].owner = std::min(f, neighbour_across(f, f));
+        }
+    }
+    for (int id = 0; id < num_philosophers; ++id) {
+        schedule(draw(timing_.think_min, timing_.think_max), id, EventKind::Hungry);
+    }
+}
+
+SimulationResult DiningSimulation::run(uint64_t meals) {
+    uint64_t target = meals_ + meals;
+    while (meals_ < target && !events_.empty()) {
+        Event event = events_.top();
+        events_.pop();
+        now_ = event.at;
+        handle(event);
+        while (!wake_.empty()) {
+            int id = wake_.back();
+            wake_.pop_back();
+            if (philosophers_[id].phase == Phase::Hungry) {
+                advance(id);
+            }
+        }
+    }
+
+    SimulationResult result;
+    result.meals = meals_;
+    result.virtual_time = now_;
+    result.hunger = hunger_.snapshot();
+    for (const auto &philosopher : philosophers_) {
+        result.eat_counts.push_back(philosopher.meals);
+    }
+    result.deadlocked =
+        events_.empty() &&
+        std::any_of(philosophers_.begin(), philosophers_.end(),
+                    [](const Philosopher &p) { return p.phase == Phase::Hungry; });
+    return result;
+}
+
+std::chrono::nanoseconds DiningSimulation::draw(std::chrono::microseconds min,
+                                                std::chrono::microseconds max) {
+    std::uniform_int_distribution<int64_t> dist(
+        std::chrono::nanoseconds(min).count(), std::chrono::nanoseconds(max).count());
+    return std::chrono::nanoseconds(dist(gen_));
+}
+
+void DiningSimulation::schedule(std::chrono::nanoseconds delay, int philosopher,
+                                EventKind kind) {
+    events_.push({now_ + delay, next_seq_++, philosopher, kind});
+}
+
+void DiningSimulation::handle(const Event &event) {
+    auto &philosopher = philosophers_[event.philosopher];
+    switch (event.kind) {
+    case EventKind::Hungry:
+        philosopher.phase = Phase::Hungry;
+        philosopher.hungry_since = now_;
+        philosopher.backoff = std::chrono::nanoseconds(TryLockBackoffForks::kMinBackoffNs);
+        wake_.push_back(event.philosopher);
+        break;
+    case EventKind::Retry:
+        philosopher.phase = Phase::Hungry;
+        wake_.push_back(event.philosopher);
+        break;
+    case EventKind::DoneEating:
+        finish_eating(event.philosopher);
+        break;
+    }
+}
+
+void DiningSimulation::advance(int id) {
+    switch (strategy_) {
+    case ForkStrategyKind::ResourceOrdering: {
+        int left = left_fork(id);
+        int right = right_fork(id);
+        if (lock_in_order(id, std::min(left, right), std::max(left, right))) {
+            start_eating(id);
+        }
+        break;
+    }
+    case ForkStrategyKind::Arbitrator: {
+        auto &philosopher = philosophers_[id];
+        if (!philosopher.seated) {
+            if (free_seats_ == 0) {
+                seat_waiters_.push_back(id);
+                return;
+            }
+            --free_seats_;
+            philosopher.seated = true;
+        }
+        if (lock_in_order(id, left_fork(id), right_fork(id))) {
+            start_eating(id);
+        }
+        break;
+    }
+    case ForkStrategyKind::AtomicBitmask:
+        advance_bitmask(id);
+        break;
+    case ForkStrategyKind::ChandyMisra:
+        advance_chandy_misra(id);
+        break;
+    case ForkStrategyKind::TryLockBackoff:
+        advance_try_lock(id);
+        break;
+    }
+}
+
+void DiningSimulation::start_eating(int id) {
+    [[maybe_unused]] int left = left_fork(id);
+    [[maybe_unused]] int right = right_fork(id);
+    assert(strategy_ == ForkStrategyKind::ChandyMisra
+               ? cm_forks_[left].owner == id && cm_forks_[right].owner == id
+               : holders_[left] == id && holders_[right] == id);
+    auto &philosopher = philosophers_[id];
+    philosopher.phase = Phase::Eating;
+    hunger_.record(now_ - philosopher.hungry_since);
+    schedule(draw(timing_.eat_min, timing_.eat_max), id, EventKind::DoneEating);
+}
+
+void DiningSimulation::finish_eating(int id) {
+    auto &philosopher = philosophers_[id];
+    ++philosopher.meals;
+    ++meals_;
+    philosopher.phase = Phase::Thinking;
+
+    int left = left_fork(id);
+    int right = right_fork(id);
+    switch (strategy_) {
+    case ForkStrategyKind::ResourceOrdering:
+    case ForkStrategyKind::TryLockBackoff:
+        release_fork(right);
+        release_fork(left);
+        break;
+    case ForkStrategyKind::Arbitrator:
+        release_fork(right);
+        release_fork(left);
+        philosopher.seated = false;
+        if (seat_waiters_.empty()) {
+            ++free_seats_;
+        } else {
+            int next = seat_waiters_.front();
+            seat_waiters_.pop_front();
+            philosophers_[next].seated = true;
+            wake_.push_back(next);
+        }
+        break;
+    case ForkStrategyKind::AtomicBitmask:
+        release_bitmask(right);
+        release_bitmask(left);
+        break;
+    case ForkStrategyKind::ChandyMisra:
+        for (int f : {left, right}) {
+            auto &fork = cm_forks_[f];
+            fork.in_use = false;
+            fork.dirty = true;
+            if (fork.requested) {
+                cm_send(f, neighbour_across(f, id));
+            }
+        }
+        break;
+    }
+    schedule(draw(timing_.think_min, timing_.think_max), id, EventKind::Hungry);
+}
+
+// Mutex-style: take each fork in turn, queueing on the first one taken.
+// Returns true once both are held.
+bool DiningSimulation::lock_in_order(int id, int first, int second) {
+    for (int fork : {first, second}) {
+        if (holders_[fork] == id) {
+            continue;
+        }
+        if (holders_[fork] != -1) {
+            waiters_[fork].push_back(id);
+            return false;
+        }
+        holders_[fork] = id;
+    }
+    return true;
+}
+
+void DiningSimulation::release_fork(int fork) {
+    if (waiters_[fork].empty()) {
+        holders_[fork] = -1;
+        return;
+    }
+    holders_[fork] = waiters_[fork].front();
+    waiters_[fork].pop_front();
+    wake_.push_back(holders_[fork]);
+}
+
+// Both forks in one step or neither; while blocked, watch whichever of
+// them is taken, like atomic::wait on the word
+void DiningSimulation::advance_bitmask(int id) {
+    int left = left_fork(id);
+    int right = right_fork(id);
+    if (holders_[left] == -1 && holders_[right] == -1) {
+        holders_[left] = holders_[right] = id;
+        start_eating(id);
+        return;
+    }
+    auto &philosopher = philosophers_[id];
+    if (holders_[left] != -1 && !philosopher.watching_left) {
+        waiters_[left].push_back(id);
+        philosopher.watching_left = true;
+    }
+    if (holders_[right] != -1 && !philosopher.watching_right) {
+        waiters_[right].push_back(id);
+        philosopher.watching_right = true;
+    }
+}
+
+// notify_all: every watcher retries, earliest first
+void DiningSimulation::release_bitmask(int fork) {
+    holders_[fork] = -1;
+    auto watchers = std::move(waiters_[fork]);
+    waiters_[fork].clear();
+    for (int id : watchers) {
+        auto &philosopher = philosophers_[id];
+        (left_fork(id) == fork ? philosopher.watching_left : philosopher.watching_right) =
+            false;
+    }
+    // wake_ is a stack; push in reverse so the first watcher goes first
+    wake_.insert(wake_.end(), watchers.rbegin(), watchers.rend());
+}
+
+void DiningSimulation::advance_chandy_misra(int id) {
+    int left = left_fork(id);
+    int right = right_fork(id);
+    cm_request(id, left);
+    cm_request(id, right);
+    if (cm_forks_[left].owner == id && cm_forks_[right].owner == id) {
+        cm_forks_[left].in_use = cm_forks_[right].in_use = true;
+        start_eating(id);
+    }
+}
+
+void DiningSimulation::cm_request(int id, int fork_index) {
+    auto &fork = cm_forks_[fork_index];
+    if (fork.owner == id) {
+        return;
+    }
+    if (fork.dirty && !fork.in_use) {
+        cm_send(fork_index, id);
+    } else {
+        fork.requested = true;
+    }
+}
+
+void DiningSimulation::cm_send(int fork_index, int to) {
+    auto &fork = cm_forks_[fork_index];
+    int from = fork.owner;
+    fork.owner = to;
+    fork.dirty = false;
+    fork.requested = false;
+    wake_.push_back(from);
+    wake_.push_back(to);
+}
+
+int DiningSimulation::neighbour_across(int fork, int id) const {
+    return id == fork ? (fork + num_philosophers_ - 1) % num_philosophers_ : fork;
+}
+
+// Block on the left fork; if the right one is taken, drop the left and
+// retry after a jittered, doubling backoff
+void DiningSimulation::advance_try_lock(int id) {
+    int left = left_fork(id);
+    int right = right_fork(id);
+    if (holders_[left] != id) {
+        if (holders_[left] != -1) {
+            waiters_[left].push_back(id);
+            return;
+        }
+        holders_[left] = id;
+    }
+    if (holders_[right] == -1) {
+        holders_[right] = id;
+        start_eating(id);
+        return;
+    }
+    release_fork(left);
+    auto &philosopher = philosophers_[id];
+    philosopher.phase = Phase::BackingOff;
+    std::uniform_int_distribution<int64_t> jitter(philosopher.backoff.count() / 2,
+                                                  philosopher.backoff.count());
+    schedule(std::chrono::nanoseconds(jitter(gen_)), id, EventKind::Retry);
+    philosopher.backoff = std::min(2 * philosopher.backoff,
+                                   std::chrono::nanoseconds(TryLockBackoffForks::kMaxBackoffNs));
+}
+
+} // namespace concurrency
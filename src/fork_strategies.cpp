@@ -0,0 +1,245 @@
+#include "fork_strategies.hpp"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace concurrency {
+
+std::unique_ptr<ForkStrategy> make_fork_strategy(ForkStrategyKind strategy, int num_philosophers) {
+    if (num_philosophers < 2) {
+        throw std::invalid_argument("A fork strategy needs at least two philosophers");
+    }
+    switch (strategy) {
+    case ForkStrategyKind::ResourceOrdering:
+        return std::make_unique<ResourceOrderingForks>(num_philosophers);
+    case ForkStrategyKind::AtomicBitmask:
+        return std::make_unique<AtomicBitmaskForks>(num_philosophers);
+    case ForkStrategyKind::ChandyMisra:
+        return std::make_unique<ChandyMisraForks>(num_philosophers);
+    case ForkStrategyKind::Arbitrator:
+        return std::make_unique<ArbitratorForks>(num_philosophers);
+    case ForkStrategyKind::TryLockBackoff:
+        return std::make_unique<TryLockBackoffForks>(num_philosophers);
+    }
+    throw std::invalid_argument("Unknown fork strategy");
+}
+
+// ResourceOrderingForks
+
+ResourceOrderingForks::ResourceOrderingForks(int num_philosophers)
+    : ForkStrategy(num_philosophers), forks_(num_philosophers) {}
+
+void ResourceOrderingForks::pick_up(int philosopher_id,
+                                    std::atomic<PhilosopherState> &state) {
+    int left = left_fork(philosopher_id);
+    int right = right_fork(philosopher_id);
+    forks_[std::min(left, right)].lock();
+    state.store(PhilosopherState::WaitRight);
+    forks_[std::max(left, right)].lock();
+}
+
+void ResourceOrderingForks::put_down(int philosopher_id) {
+    int left = left_fork(philosopher_id);
+    int right = right_fork(philosopher_id);
+    forks_[std::max(left, right)].unlock();
+    forks_[std::min(left, right)].unlock();
+}
+
+// AtomicBitmaskForks
+
+AtomicBitmaskForks::AtomicBitmaskForks(int num_philosophers)
+    : ForkStrategy(num_philosophers),
+      words_((num_philosophers + kForksPerWord - 1) / kForksPerWord) {}
+
+void AtomicBitmaskForks::pick_up(int philosopher_id,
+                                 std::atomic<PhilosopherState> &state) {
+    // Waiting for both at once; there is no "holding one" state
+    int left = left_fork(philosopher_id);
+    int right = right_fork(philosopher_id);
+    if (word_of(left) == word_of(right)) {
+        claim(word_of(left), bit_of(left) | bit_of(right));
+    } else {
+        // The pair spans two words: claim in word order, which is fork
+        // index order, so the ring can't close into a cycle
+        int first = std::min(left, right);
+        int second = std::max(left, right);
+        claim(word_of(first), bit_of(first));
+        state.store(PhilosopherState::WaitRight);
+        claim(word_of(second), bit_of(second));
+    }
+}
+
+void AtomicBitmaskForks::put_down(int philosopher_id) {
+    int left = left_fork(philosopher_id);
+    int right = right_fork(philosopher_id);
+    if (word_of(left) == word_of(right)) {
+        release(word_of(left), bit_of(left) | bit_of(right));
+    } else {
+        release(word_of(left), bit_of(left));
+        release(word_of(right), bit_of(right));
+    }
+}
+
+// Set all of `mask` in one CAS once none of it is taken, sleeping on the
+// word while any of it is
+void AtomicBitmaskForks::claim(int word, uint32_t mask) {
+    auto &forks = words_[word];
+    uint32_t current = forks.load(std::memory_order_relaxed);
+    while (true) {
+        if (current & mask) {
+            forks.wait(current, std::memory_order_relaxed);
+            current = forks.load(std::memory_order_relaxed);
+        } else if (forks.compare_exchange_weak(current, current | mask,
+                                               std::memory_order_acquire,
+                                               std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+void AtomicBitmaskForks::release(int word, uint32_t mask) {
+    words_[word].fetch_and(~mask, std::memory_order_release);
+    words_[word].notify_all();
+}
+
+// ChandyMisraForks
+
+ChandyMisraForks::ChandyMisraForks(int num_philosophers)
+    : ForkStrategy(num_philosophers), forks_(num_philosophers),
+      inboxes_(num_philosophers) {
+    // Every fork starts dirty at the lower-numbered neighbour, which makes
+    // the precedence graph acyclic
+    for (int f = 0; f < num_philosophers; ++f) {
+        forks_[f].owner = std::min(f, neighbour_across(f, f));
+    }
+}
+
+void ChandyMisraForks::pick_up(int philosopher_id, std::atomic<PhilosopherState> &) {
+    auto &inbox = inboxes_[philosopher_id];
+    while (true) {
+        // Read the inbox first so a fork sent after the checks below still
+        // wakes us
+        uint32_t seen = inbox.load(std::memory_order_acquire);
+        request(philosopher_id, left_fork(philosopher_id));
+        request(philosopher_id, right_fork(philosopher_id));
+        if (try_start_eating(philosopher_id)) {
+            return;
+        }
+        inbox.wait(seen, std::memory_order_acquire);
+    }
+}
+
+// Both forks are dirty now; honour any request tokens that arrived
+void ChandyMisraForks::put_down(int philosopher_id) {
+    for (int f : {left_fork(philosopher_id), right_fork(philosopher_id)}) {
+        auto &fork = forks_[f];
+        std::lock_guard<std::mutex> lock(fork.mutex);
+        fork.in_use = false;
+        fork.dirty = true;
+        if (fork.requested) {
+            send(fork, neighbour_across(f, philosopher_id));
+        }
+    }
+}
+
+int ChandyMisraForks::neighbour_across(int fork, int philosopher_id) const {
+    return philosopher_id == fork ? (fork + num_philosophers_ - 1) % num_philosophers_
+                                  : fork;
+}
+
+// Ask for a fork we lack. The owner must yield a dirty fork it isn't eating
+// with, so take that one straight away; otherwise leave the request token
+// with the fork and the owner sends it after its meal.
+void ChandyMisraForks::request(int philosopher_id, int fork_index) {
+    auto &fork = forks_[fork_index];
+    std::lock_guard<std::mutex> lock(fork.mutex);
+    if (fork.owner == philosopher_id) {
+        return;
+    }
+    if (fork.dirty && !fork.in_use) {
+        send(fork, philosopher_id);
+    } else {
+        fork.requested = true;
+    }
+}
+
+// Holding both forks: mark them in use so neither can be taken mid-meal
+bool ChandyMisraForks::try_start_eating(int philosopher_id) {
+    auto &left = forks_[left_fork(philosopher_id)];
+    auto &right = forks_[right_fork(philosopher_id)];
+    std::scoped_lock lock(left.mutex, right.mutex);
+    if (left.owner != philosopher_id || right.owner != philosopher_id) {
+        return false;
+    }
+    left.in_use = right.in_use = true;
+    return true;
+}
+
+// Caller holds fork.mutex. Forks travel clean; both ends are told, since
+// a hungry previous owner must ask for it back.
+void ChandyMisraForks::send(SharedFork &fork, int to) {
+    int from = fork.owner;
+    fork.owner = to;
+    fork.dirty = false;
+    fork.requested = false;
+    for (int id : {from, to}) {
+        inboxes_[id].fetch_add(1, std::memory_order_release);
+        inboxes_[id].notify_one();
+    }
+}
+
+// ArbitratorForks
+
+ArbitratorForks::ArbitratorForks(int num_philosophers)
+    : ForkStrategy(num_philosophers), seats_(num_philosophers - 1),
+      forks_(num_philosophers) {}
+
+// Left then right is a cyclic lock order; the seat limit is what rules out
+// deadlock, so lock-order checkers (TSan) still report a potential one
+void ArbitratorForks::pick_up(int philosopher_id, std::atomic<PhilosopherState> &state) {
+    seats_.acquire();
+    forks_[left_fork(philosopher_id)].lock();
+    state.store(PhilosopherState::WaitRight);
+    forks_[right_fork(philosopher_id)].lock();
+}
+
+void ArbitratorForks::put_down(int philosopher_id) {
+    forks_[right_fork(philosopher_id)].unlock();
+    forks_[left_fork(philosopher_id)].unlock();
+    seats_.release();
+}
+
+// TryLockBackoffForks
+
+TryLockBackoffForks::TryLockBackoffForks(int num_philosophers)
+    : ForkStrategy(num_philosophers), forks_(num_philosophers) {}
+
+void TryLockBackoffForks::pick_up(int philosopher_id,
+                                  std::atomic<PhilosopherState> &state) {
+    auto &left = forks_[left_fork(philosopher_id)];
+    auto &right = forks_[right_fork(philosopher_id)];
+    thread_local std::minstd_rand gen(std::random_device{}());
+    int64_t backoff = kMinBackoffNs;
+    while (true) {
+        state.store(PhilosopherState::WaitLeft);
+        left.lock();
+        state.store(PhilosopherState::WaitRight);
+        if (right.try_lock()) {
+            return;
+        }
+        left.unlock();
+        // Random jitter keeps neighbours from retrying in lockstep
+        std::uniform_int_distribution<int64_t> jitter(backoff / 2, backoff);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(jitter(gen)));
+        backoff = std::min(backoff * 2, kMaxBackoffNs);
+    }
+}
+
+void TryLockBackoffForks::put_down(int philosopher_id) {
+    forks_[right_fork(philosopher_id)].unlock();
+    forks_[left_fork(philosopher_id)].unlock();
+}
+
+} // namespace concurrency
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "buffer_pool.hpp"
+#include "producer_consumer.hpp"
+#include "thread_safe_queue.hpp"
+
+using namespace concurrency;
+
+TEST(BufferPoolTest, RoundsUpToSizeClass) {
+    BufferPool pool(4096, 32768, 4);
+    EXPECT_EQ(pool.num_classes(), 4);
+    EXPECT_EQ(pool.class_size(3), 32768);
+
+    auto small = pool.acquire(100);
+    EXPECT_EQ(small.size(), 100);
+    EXPECT_EQ(small.capacity(), 4096);
+    auto medium = pool.acquire(5000);
+    EXPECT_EQ(medium.capacity(), 8192);
+    EXPECT_EQ(pool.available(0), 3);
+    EXPECT_EQ(pool.available(1), 3);
+    EXPECT_EQ(pool.in_use(), 2);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small.data()) % 4096, 0);
+
+    EXPECT_THROW(pool.acquire(32769), std::invalid_argument);
+    EXPECT_THROW(BufferPool(3000, 8192, 4), std::invalid_argument);
+    EXPECT_THROW(BufferPool(8192, 4096, 4), std::invalid_argument);
+}
+
+TEST(BufferPoolTest, SlicesShareBufferAndReturnItOnLastRelease) {
+    BufferPool pool(4096, 4096, 2);
+    auto buffer = pool.acquire(1000);
+    std::memset(buffer.data(), 'a', buffer.size());
+
+    auto header = buffer.slice(0, 16);
+    auto body = buffer.slice(16, 984);
+    EXPECT_EQ(body.data(), buffer.data() + 16);
+    EXPECT_EQ(buffer.use_count(), 3);
+    EXPECT_THROW(body.slice(900, 100), std::out_of_range);
+
+    auto tail = body.slice(980, 4);
+    EXPECT_EQ(tail.data(), buffer.data() + 996);
+    EXPECT_EQ(static_cast<char>(tail.bytes()[0]), 'a');
+
+    buffer.reset();
+    header.reset();
+    body.reset();
+    EXPECT_EQ(pool.available(0), 1);  // `tail` still holds the buffer
+    tail.reset();
+    EXPECT_EQ(pool.available(0), 2);
+}
+
+TEST(BufferPoolTest, TryAcquireNeverBlocksAndAcquireWaits) {
+    BufferPool pool(4096, 4096, 1);
+    auto held = pool.acquire(10);
+    EXPECT_FALSE(pool.try_acquire(10));
+
+    std::atomic<bool> got{false};
+    std::thread waiter([&]() {
+        auto buffer = pool.acquire(10);
+        got = static_cast<bool>(buffer);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(got.load());
+    held.reset();
+    waiter.join();
+    EXPECT_TRUE(got.load());
+}
+
+TEST(BufferPoolTest, SlicesPassThroughQueuesWithoutCopying) {
+    BufferPool pool(4096, 8192, 8);
+    ThreadSafeQueue<BufferSlice> queue;
+    auto buffer = pool.acquire(4096);
+    std::byte *data = buffer.data();
+    queue.push(buffer.slice(0, 2048));
+    queue.push(std::move(buffer));
+
+    auto first = queue.wait_and_pop();
+    auto second = queue.wait_and_pop();
+    EXPECT_EQ(first.data(), data);
+    EXPECT_EQ(second.data(), data);
+    EXPECT_EQ(second.use_count(), 2);
+
+    // Through a ProducerConsumer: every buffer comes back once consumed
+    ProducerConsumer<BufferSlice> pc(4);
+    std::atomic<size_t> bytes{0};
+    pc.start(2, 2, [&]() { return pool.acquire(8000); },
+             [&](BufferSlice slice) { bytes.fetch_add(slice.size()); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pc.stop();
+    EXPECT_GT(bytes.load(), 0);
+    first.reset();
+    second.reset();
+    EXPECT_EQ(pool.in_use(), 0);
+}
+
+TEST(BufferPoolTest, ArenaIsHugePageAligned) {
+    BufferPool pool;
+    EXPECT_GE(pool.arena_bytes(), 32 * (4 + 8 + 16 + 32 + 64) * 1024);
+#ifdef __linux__
+    EXPECT_EQ(pool.arena_bytes() % BufferPool::kHugePageSize, 0);
+#endif
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "coroutine_producer_consumer.hpp"
+
+using namespace concurrency;
+
+class CoroutineProducerConsumerTest : public ::testing::Test {
+protected:
+    CoroutineProducerConsumer<int> pc{10, 4}; // buffer 10, 4 workers
+};
+
+TEST_F(CoroutineProducerConsumerTest, BasicProducerConsumer) {
+    std::atomic<int> next_item{0};
+    std::atomic<long> sum_consumed{0};
+
+    auto producer_func = [&]() -> int { return next_item.fetch_add(1); };
+    auto consumer_func = [&](int item) { sum_consumed.fetch_add(item); };
+
+    pc.start(1, 1, producer_func, consumer_func);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    pc.stop();
+
+    EXPECT_GT(pc.items_produced(), 0);
+    EXPECT_EQ(pc.items_produced(), pc.items_consumed());
+    EXPECT_EQ(pc.current_buffer_size(), 0);
+}
+
+TEST_F(CoroutineProducerConsumerTest, ManyLogicalWorkersOnFewThreads) {
+    std::mutex ids_mutex;
+    std::set<std::thread::id> thread_ids;
+    std::atomic<int> consumed{0};
+
+    auto producer_func = [&]() -> int { return 1; };
+    auto consumer_func = [&](int item) {
+        consumed.fetch_add(item);
+        std::lock_guard<std::mutex> lock(ids_mutex);
+        thread_ids.insert(std::this_thread::get_id());
+    };
+
+    pc.start(100, 100, producer_func, consumer_func);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    pc.stop();
+
+    EXPECT_GT(consumed.load(), 0);
+    EXPECT_EQ(pc.items_produced(), pc.items_consumed());
+    // 200 logical workers, but never more than 4 OS threads
+    EXPECT_LE(thread_ids.size(), pc.num_workers());
+}
+
+TEST_F(CoroutineProducerConsumerTest, BufferBounds) {
+    std::atomic<size_t> max_buffered{0};
+
+    auto producer_func = [&]() -> int { return 42; };
+    auto consumer_func = [&](int) {
+        size_t buffered = pc.current_buffer_size();
+        size_t seen_max = max_buffered.load();
+        while (buffered > seen_max &&
+               !max_buffered.compare_exchange_weak(seen_max, buffered)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    };
+
+    pc.start(3, 1, producer_func, consumer_func);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    pc.stop();
+
+    EXPECT_EQ(max_buffered.load(), 10);
+    EXPECT_EQ(pc.items_produced(), pc.items_consumed());
+}
+
+TEST(AsyncChannelTest, PushResumesWaitingConsumerDirectly) {
+    CoroutineScheduler scheduler(1);
+    AsyncChannel<int> channel(1, scheduler);
+    std::atomic<int> received{0};
+    std::atomic<bool> done{false};
+
+    auto consumer = [&]() -> DetachedTask {
+        co_await scheduler.schedule();
+        auto item = co_await channel.pop(); // Suspends: channel is empty
+        received = item.value_or(-1);
+        done = true;
+        done.notify_all();
+    };
+    consumer();
+
+    // Give the consumer time to park on the empty channel
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(done.load());
+
+    auto producer = [&]() -> DetachedTask {
+        co_await scheduler.schedule();
+        EXPECT_TRUE(co_await channel.push(7));
+    };
+    producer();
+
+    done.wait(false);
+    EXPECT_EQ(received.load(), 7);
+    EXPECT_EQ(channel.size(), 0); // Handed over without touching the buffer
+}
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <numeric>
+#include <thread>
 #include "dining_philosophers.hpp"
 
 using namespace concurrency;
@@ -66,4 +71,223 @@ TEST_F(DiningPhilosophersTest, FairnessCheck) {
         double ratio = static_cast<double>(max_eats) / min_eats;
         EXPECT_LT(ratio, 10.0) << "Eating distribution is too unfair";
     }
-}
\ No newline at end of file
+}
+
+namespace {
+// Sub-millisecond meals so a run covers thousands of them
+DiningPhilosophers::Timing fast_timing() {
+    using std::chrono::microseconds;
+    return {microseconds(0), microseconds(200), microseconds(0), microseconds(100)};
+}
+
+// A mutex whose waits can be called off: after open() lock() no longer
+// blocks, so a deadlocked table can still be stopped
+class BreakableMutex {
+public:
+    void lock() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return !held_ || open_; });
+        held_ = true;
+    }
+
+    void unlock() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            held_ = false;
+        }
+        cv_.notify_all();
+    }
+
+    void open() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool held_ = false;
+    bool open_ = false;
+};
+
+// The textbook deadlock: left fork, then right. Nobody reaches for a right
+// fork until everyone holds a left one, so the table always locks up.
+class LeftThenRightForks : public ForkStrategy {
+public:
+    explicit LeftThenRightForks(int num_philosophers)
+        : ForkStrategy(num_philosophers), forks_(num_philosophers) {}
+
+    void pick_up(int philosopher_id, std::atomic<PhilosopherState> &state) override {
+        forks_[left_fork(philosopher_id)].lock();
+        state.store(PhilosopherState::WaitRight);
+        seated_.fetch_add(1);
+        while (seated_.load() < num_philosophers_) {
+            std::this_thread::yield();
+        }
+        forks_[right_fork(philosopher_id)].lock();
+    }
+
+    void put_down(int philosopher_id) override {
+        forks_[right_fork(philosopher_id)].unlock();
+        forks_[left_fork(philosopher_id)].unlock();
+    }
+
+    const char *name() const override { return "left-then-right"; }
+    bool uses_lock(const void *lock) const override { return within(forks_, lock); }
+
+    void open() {
+        for (auto &fork : forks_) {
+            fork.native().open();
+        }
+    }
+
+private:
+    std::vector<MonitoredMutex<BreakableMutex>> forks_;
+    std::atomic<int> seated_{0};
+};
+
+} // namespace
+
+TEST(DiningPhilosophersBitmaskTest, EveryoneEats) {
+    DiningPhilosophers philosophers(5, DiningPhilosophers::Strategy::AtomicBitmask);
+    EXPECT_STREQ(philosophers.fork_strategy().name(), "bitmask");
+    philosophers.set_timing(fast_timing());
+    philosophers.start_dining();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_FALSE(philosophers.is_deadlocked());
+    philosophers.stop_dining();
+
+    for (int count : philosophers.get_eat_counts()) {
+        EXPECT_GT(count, 0) << "A philosopher never got to eat";
+    }
+}
+
+TEST(DiningPhilosophersBitmaskTest, RingSpanningSeveralWords) {
+    // Philosophers 31, 63, ... hold forks in two words, as does the last
+    // one (forks 129 and 0)
+    DiningPhilosophers philosophers(130, DiningPhilosophers::Strategy::AtomicBitmask);
+    philosophers.set_timing(fast_timing());
+    philosophers.start_dining();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    philosophers.stop_dining();
+
+    auto eat_counts = philosophers.get_eat_counts();
+    ASSERT_EQ(eat_counts.size(), 130u);
+    for (int id : {0, 31, 32, 63, 127, 128, 129}) {
+        EXPECT_GT(eat_counts[id], 0) << "Philosopher " << id << " never ate";
+    }
+}
+
+TEST(DiningPhilosophersBitmaskTest, ZeroLengthMealsMakeProgress) {
+    // No sleeping at all: every philosopher hammers the one shared word
+    DiningPhilosophers philosophers(64, DiningPhilosophers::Strategy::AtomicBitmask);
+    philosophers.set_timing({std::chrono::microseconds(0), std::chrono::microseconds(0),
+                             std::chrono::microseconds(0), std::chrono::microseconds(0)});
+    philosophers.start_dining();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    philosophers.stop_dining();
+
+    int total = 0;
+    for (int count : philosophers.get_eat_counts()) {
+        total += count;
+    }
+    EXPECT_GT(total, 0);
+}
+
+TEST(DiningPhilosophersTimingTest, RejectsInvertedRanges) {
+    DiningPhilosophers philosophers(5);
+    DiningPhilosophers::Timing timing;
+    timing.eat_min = std::chrono::microseconds(10);
+    timing.eat_max = std::chrono::microseconds(5);
+    EXPECT_THROW(philosophers.set_timing(timing), std::invalid_argument);
+    EXPECT_THROW(DiningPhilosophers(1), std::invalid_argument);
+}
+
+TEST(DiningPhilosophersChandyMisraTest, EveryoneEats) {
+    DiningPhilosophers philosophers(5, DiningPhilosophers::Strategy::ChandyMisra);
+    philosophers.set_timing(fast_timing());
+    philosophers.start_dining();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_FALSE(philosophers.is_deadlocked());
+    philosophers.stop_dining();
+
+    for (int count : philosophers.get_eat_counts()) {
+        EXPECT_GT(count, 0) << "A philosopher never got to eat";
+    }
+}
+
+TEST(DiningPhilosophersChandyMisraTest, TwoPhilosophersShareBothForks) {
+    DiningPhilosophers philosophers(2, DiningPhilosophers::Strategy::ChandyMisra);
+    philosophers.set_timing(fast_timing());
+    philosophers.start_dining();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    philosophers.stop_dining();
+
+    auto eat_counts = philosophers.get_eat_counts();
+    EXPECT_GT(eat_counts[0], 0);
+    EXPECT_GT(eat_counts[1], 0);
+}
+
+TEST(DiningPhilosophersChandyMisraTest, LargeRingWithoutSleeping) {
+    DiningPhilosophers philosophers(500, DiningPhilosophers::Strategy::ChandyMisra);
+    philosophers.set_timing({std::chrono::microseconds(0), std::chrono::microseconds(0),
+                             std::chrono::microseconds(0), std::chrono::microseconds(0)});
+    philosophers.start_dining();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    philosophers.stop_dining();
+
+    auto eat_counts = philosophers.get_eat_counts();
+    int starved = static_cast<int>(std::count(eat_counts.begin(), eat_counts.end(), 0));
+    EXPECT_EQ(starved, 0);
+    uint64_t total = std::accumulate(eat_counts.begin(), eat_counts.end(), uint64_t{0});
+    EXPECT_EQ(philosophers.hunger_times().count(), total);
+}
+
+TEST(DiningPhilosophersStrategyTest, EveryStrategyFeedsEveryone) {
+    using Strategy = DiningPhilosophers::Strategy;
+    for (auto strategy : {Strategy::ResourceOrdering, Strategy::AtomicBitmask,
+                          Strategy::ChandyMisra, Strategy::Arbitrator,
+                          Strategy::TryLockBackoff}) {
+        DiningPhilosophers philosophers(7, strategy);
+        philosophers.set_timing(fast_timing());
+        philosophers.start_dining();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        philosophers.stop_dining();
+
+        for (int count : philosophers.get_eat_counts()) {
+            EXPECT_GT(count, 0) << philosophers.fork_strategy().name()
+                                << ": a philosopher never got to eat";
+        }
+    }
+}
+
+TEST(DiningPhilosophersStrategyTest, AcceptsCustomStrategy) {
+    DiningPhilosophers philosophers(std::make_unique<ArbitratorForks>(4));
+    EXPECT_STREQ(philosophers.fork_strategy().name(), "arbitrator");
+    EXPECT_EQ(philosophers.get_eat_counts().size(), 4u);
+    EXPECT_THROW(DiningPhilosophers(std::unique_ptr<ForkStrategy>()),
+                 std::invalid_argument);
+}
+
+TEST(DiningPhilosophersStrategyTest, DetectsDeadlockedCustomStrategy) {
+    auto strategy = std::make_unique<LeftThenRightForks>(3);
+    auto &forks = *strategy;
+    DiningPhilosophers philosophers(std::move(strategy));
+    philosophers.set_timing(fast_timing());
+    philosophers.start_dining();
+
+    bool deadlocked = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!deadlocked && std::chrono::steady_clock::now() < deadline) {
+        deadlocked = philosophers.is_deadlocked();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(deadlocked);
+
+    forks.open();
+    philosophers.stop_dining();
+    EXPECT_FALSE(philosophers.is_deadlocked());
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include "dining_simulation.hpp"
+
+using namespace concurrency;
+using std::chrono::microseconds;
+
+namespace {
+
+const ForkStrategyKind kAllStrategies[] = {
+    ForkStrategyKind::ResourceOrdering, ForkStrategyKind::AtomicBitmask,
+    ForkStrategyKind::ChandyMisra, ForkStrategyKind::Arbitrator,
+    ForkStrategyKind::TryLockBackoff};
+
+// Meals about as long as thinking, so forks are contended most of the time
+const DiningSimulation::Timing kHungry{microseconds(0), microseconds(100),
+                                       microseconds(0), microseconds(50)};
+
+} // namespace
+
+TEST(DiningSimulationTest, SameSeedSameRun) {
+    for (auto strategy : kAllStrategies) {
+        DiningSimulation a(7, strategy, kHungry, 42);
+        DiningSimulation b(7, strategy, kHungry, 42);
+        auto first = a.run(10'000);
+        auto second = b.run(10'000);
+        EXPECT_EQ(first.eat_counts, second.eat_counts);
+        EXPECT_EQ(first.virtual_time, second.virtual_time);
+        EXPECT_EQ(first.hunger.buckets, second.hunger.buckets);
+    }
+}
+
+TEST(DiningSimulationTest, DifferentSeedsDiffer) {
+    DiningSimulation a(7, ForkStrategyKind::ResourceOrdering, kHungry, 1);
+    DiningSimulation b(7, ForkStrategyKind::ResourceOrdering, kHungry, 2);
+    EXPECT_NE(a.run(10'000).virtual_time, b.run(10'000).virtual_time);
+}
+
+// The fairness bound holds for the idealised FIFO hand-off the simulation
+// models, not for the threaded strategies
+TEST(DiningSimulationTest, EveryStrategyFeedsEveryone) {
+    for (auto strategy : kAllStrategies) {
+        for (int n : {2, 5, 100}) {
+            DiningSimulation simulation(n, strategy, kHungry, 7);
+            auto result = simulation.run(5'000);
+            EXPECT_FALSE(result.deadlocked);
+            EXPECT_EQ(result.meals, 5'000u);
+            EXPECT_GE(result.hunger.count(), result.meals)
+                << "Every meal started records a hunger time";
+            EXPECT_GT(*std::min_element(result.eat_counts.begin(), result.eat_counts.end()),
+                      0u);
+            EXPECT_GT(result.jain_fairness(), 0.95)
+                << static_cast<int>(strategy) << " with " << n << " philosophers";
+        }
+    }
+}
+
+TEST(DiningSimulationTest, MillionMealsInVirtualTime) {
+    // Default timing is 10-100 ms thinking and 10-50 ms eating: hours of
+    // dining, simulated without sleeping
+    DiningSimulation simulation(5, ForkStrategyKind::ChandyMisra);
+    auto start = std::chrono::steady_clock::now();
+    auto result = simulation.run(1'000'000);
+    auto wall = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(result.meals, 1'000'000u);
+    EXPECT_GT(result.virtual_time, std::chrono::hours(1));
+    EXPECT_LT(wall, std::chrono::seconds(10));
+}
+
+TEST(DiningSimulationTest, RunsAccumulate) {
+    DiningSimulation simulation(5, ForkStrategyKind::Arbitrator, kHungry);
+    auto first = simulation.run(1'000);
+    auto second = simulation.run(1'000);
+    EXPECT_EQ(first.meals, 1'000u);
+    EXPECT_EQ(second.meals, 2'000u);
+    EXPECT_GT(second.virtual_time, first.virtual_time);
+}
+
+TEST(DiningSimulationTest, RejectsBadArguments) {
+    EXPECT_THROW(DiningSimulation(1, ForkStrategyKind::ResourceOrdering), std::invalid_argument);
+    DiningSimulation::Timing inverted;
+    inverted.think_min = microseconds(10);
+    inverted.think_max = microseconds(1);
+    EXPECT_THROW(DiningSimulation(5, ForkStrategyKind::ResourceOrdering, inverted),
+                 std::invalid_argument);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "elastic_resource_pool.hpp"
+
+using namespace concurrency;
+
+struct SlowConnection {
+    static std::atomic<int> live;
+    int id;
+    explicit SlowConnection(int connection_id) : id(connection_id) {
+        live.fetch_add(1);
+    }
+    ~SlowConnection() { live.fetch_sub(1); }
+};
+std::atomic<int> SlowConnection::live{0};
+
+class ElasticResourcePoolTest : public ::testing::Test {
+protected:
+    std::atomic<int> next_id{0};
+    ElasticResourcePool<SlowConnection>::Factory factory = [this]() {
+        return std::make_shared<SlowConnection>(next_id.fetch_add(1));
+    };
+};
+
+TEST_F(ElasticResourcePoolTest, CreatesLazilyUpToMax) {
+    ElasticResourcePool<SlowConnection> pool(factory, 1, 3);
+    EXPECT_EQ(pool.size(), 1);
+    EXPECT_EQ(pool.total_created(), 1);
+
+    auto a = pool.acquire();  // Reuses the warm resource
+    EXPECT_EQ(pool.total_created(), 1);
+    auto b = pool.acquire();
+    auto c = pool.acquire();
+    EXPECT_EQ(pool.size(), 3);
+    EXPECT_EQ(pool.current_usage(), 3);
+
+    EXPECT_FALSE(pool.try_acquire(std::chrono::milliseconds(20)));
+    EXPECT_EQ(pool.total_created(), 3);
+
+    pool.release(b);
+    auto d = pool.try_acquire(std::chrono::milliseconds(20));
+    EXPECT_EQ(d.get(), b.get());
+    pool.release(a);
+    pool.release(c);
+    pool.release(d);
+    EXPECT_EQ(pool.idle_count(), 3);
+    EXPECT_EQ(pool.peak_usage(), 3);
+}
+
+TEST_F(ElasticResourcePoolTest, ReaperEvictsIdleDownToMin) {
+    {
+        ElasticResourcePool<SlowConnection> pool(factory, 1, 4,
+                                                 std::chrono::milliseconds(30));
+        std::vector<std::shared_ptr<SlowConnection>> held;
+        for (int i = 0; i < 4; ++i) {
+            held.push_back(pool.acquire());
+        }
+        for (auto &resource : held) {
+            pool.release(resource);
+        }
+        held.clear();
+        EXPECT_EQ(pool.size(), 4);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        EXPECT_EQ(pool.size(), 1);
+        EXPECT_EQ(pool.total_evicted(), 3);
+        EXPECT_EQ(SlowConnection::live.load(), 1);
+
+        // Evicted capacity can be recreated on demand
+        ResourceGuard<SlowConnection, ElasticResourcePool<SlowConnection>> g1(pool);
+        ResourceGuard<SlowConnection, ElasticResourcePool<SlowConnection>> g2(pool);
+        EXPECT_TRUE(g1.valid() && g2.valid());
+        EXPECT_EQ(pool.total_created(), 5);
+    }
+    EXPECT_EQ(SlowConnection::live.load(), 0);
+}
+
+TEST_F(ElasticResourcePoolTest, WarmupRunsInParallel) {
+    auto slow_factory = [this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return std::make_shared<SlowConnection>(next_id.fetch_add(1));
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    ElasticResourcePool<SlowConnection> pool(slow_factory, 4, 8);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(pool.size(), 4);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(150));  // Serial: 200ms
+}
+
+TEST_F(ElasticResourcePoolTest, FactoryFailureReturnsPermit) {
+    std::atomic<bool> fail{true};
+    auto flaky_factory = [&]() -> std::shared_ptr<SlowConnection> {
+        if (fail.load()) {
+            throw std::runtime_error("connect failed");
+        }
+        return std::make_shared<SlowConnection>(0);
+    };
+
+    ElasticResourcePool<SlowConnection> pool(flaky_factory, 0, 1);
+    EXPECT_THROW(pool.acquire(), std::runtime_error);
+    EXPECT_EQ(pool.size(), 0);
+
+    fail = false;
+    auto resource = pool.try_acquire(std::chrono::milliseconds(20));
+    EXPECT_TRUE(resource != nullptr);
+    pool.release(resource);
+}
+
+TEST_F(ElasticResourcePoolTest, RejectsForeignResource) {
+    ElasticResourcePool<SlowConnection> pool(factory, 0, 1);
+    auto own = pool.acquire();
+    EXPECT_THROW(pool.release(std::make_shared<SlowConnection>(99)),
+                 std::invalid_argument);
+    EXPECT_EQ(pool.idle_count(), 0);
+    EXPECT_EQ(pool.size(), 1);
+    pool.release(own);
+    EXPECT_EQ(pool.idle_count(), 1);
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "fork_strategies.hpp"
+
+using namespace concurrency;
+
+namespace {
+
+const ForkStrategyKind kAllStrategies[] = {
+    ForkStrategyKind::ResourceOrdering, ForkStrategyKind::AtomicBitmask,
+    ForkStrategyKind::ChandyMisra, ForkStrategyKind::Arbitrator,
+    ForkStrategyKind::TryLockBackoff};
+
+// Run `n` philosophers through `meals` meals each with no thinking, checking
+// that no two neighbours ever eat at once. Returns the violations seen.
+int neighbour_violations(ForkStrategy &forks, int meals) {
+    int n = forks.num_philosophers();
+    std::vector<std::atomic<bool>> eating(n);
+    std::vector<std::atomic<PhilosopherState>> states(n);
+    std::atomic<int> violations{0};
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id < n; ++id) {
+        threads.emplace_back([&, id]() {
+            for (int meal = 0; meal < meals; ++meal) {
+                forks.pick_up(id, states[id]);
+                eating[id].store(true);
+                if (eating[(id + 1) % n].load() || eating[(id + n - 1) % n].load()) {
+                    violations.fetch_add(1);
+                }
+                std::this_thread::yield();
+                eating[id].store(false);
+                forks.put_down(id);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return violations.load();
+}
+
+} // namespace
+
+TEST(ForkStrategiesTest, NeighboursNeverEatTogether) {
+    // 2 shares both forks; 40 spans two bitmask words
+    for (int n : {2, 5, 40}) {
+        for (auto strategy : kAllStrategies) {
+            auto forks = make_fork_strategy(strategy, n);
+            EXPECT_EQ(neighbour_violations(*forks, 200), 0)
+                << forks->name() << " with " << n << " philosophers";
+        }
+    }
+}
+
+TEST(ForkStrategiesTest, ResourceOrderingReportsHoldingOneFork) {
+    ResourceOrderingForks forks(3);
+    std::atomic<PhilosopherState> state{PhilosopherState::WaitLeft};
+    forks.pick_up(0, state);
+    EXPECT_EQ(state.load(), PhilosopherState::WaitRight);
+    forks.put_down(0);
+}
+
+TEST(ForkStrategiesTest, RejectsTooFewPhilosophers) {
+    for (auto strategy : kAllStrategies) {
+        EXPECT_THROW(make_fork_strategy(strategy, 1), std::invalid_argument);
+    }
+}
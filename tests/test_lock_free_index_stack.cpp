@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "lock_free_index_stack.hpp"
+
+using namespace concurrency;
+
+TEST(LockFreeIndexStackTest, LifoOrder) {
+    LockFreeIndexStack stack(4);
+    EXPECT_TRUE(stack.empty());
+    EXPECT_EQ(stack.pop(), LockFreeIndexStack::npos);
+
+    stack.push(2);
+    stack.push(0);
+    stack.push(3);
+    EXPECT_EQ(stack.pop(), 3u);
+    EXPECT_EQ(stack.pop(), 0u);
+    EXPECT_EQ(stack.pop(), 2u);
+    EXPECT_TRUE(stack.empty());
+}
+
+TEST(LockFreeIndexStackTest, ConcurrentPopPushKeepsEveryIndexOnce) {
+    const uint32_t capacity = 16;
+    LockFreeIndexStack stack(capacity);
+    for (uint32_t i = 0; i < capacity; ++i) {
+        stack.push(i);
+    }
+
+    std::vector<std::atomic<int>> owners(capacity);
+    std::atomic<int> violations{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 20000; ++j) {
+                uint32_t index = stack.pop();
+                if (index == LockFreeIndexStack::npos) {
+                    continue;
+                }
+                if (owners[index].fetch_add(1) != 0) {
+                    violations.fetch_add(1);
+                }
+                owners[index].fetch_sub(1);
+                stack.push(index);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(violations.load(), 0);
+    std::vector<bool> seen(capacity, false);
+    uint32_t index;
+    while ((index = stack.pop()) != LockFreeIndexStack::npos) {
+        ASSERT_LT(index, capacity);
+        EXPECT_FALSE(seen[index]);
+        seen[index] = true;
+    }
+    for (bool s : seen) {
+        EXPECT_TRUE(s);
+    }
+}
@@ -0,0 +1,296 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include "lock_monitor.hpp"
+#include "read_write_lock.hpp"
+
+using namespace concurrency;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Scan until `done(report)` or give up after `timeout`
+template<typename Done>
+LockReport scan_until(Done done, std::chrono::nanoseconds threshold = 1s,
+                      std::chrono::milliseconds timeout = 1500ms) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    LockReport report;
+    do {
+        report = LockMonitor::global().scan(threshold);
+        if (done(report)) {
+            break;
+        }
+        std::this_thread::sleep_for(1ms);
+    } while (std::chrono::steady_clock::now() < deadline);
+    return report;
+}
+
+bool involves(const LockReport &report, const void *lock) {
+    for (const auto &cycle : report.cycles) {
+        for (const auto &wait : cycle) {
+            if (wait.lock == lock) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// A mutex whose waits can be called off: after open() lock() no longer
+// blocks, so a test can build a real deadlock and still join its threads
+class BreakableMutex {
+public:
+    void lock() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return !held_ || open_; });
+        held_ = true;
+    }
+
+    void unlock() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            held_ = false;
+        }
+        cv_.notify_all();
+    }
+
+    void open() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool held_ = false;
+    bool open_ = false;
+};
+
+// Thread i holds lock i, then blocks on lock i + 1 until the ring is opened
+void deadlock_ring(std::vector<MonitoredMutex<BreakableMutex>> &locks,
+                   std::vector<std::thread> &threads, std::atomic<int> &holding) {
+    int n = static_cast<int>(locks.size());
+    for (int i = 0; i < n; ++i) {
+        threads.emplace_back([&locks, &holding, i, n]() {
+            std::lock_guard<MonitoredMutex<BreakableMutex>> first(locks[i]);
+            holding.fetch_add(1);
+            while (holding.load() < n) {
+                std::this_thread::yield();
+            }
+            std::lock_guard<MonitoredMutex<BreakableMutex>> second(locks[(i + 1) % n]);
+        });
+    }
+}
+
+void open_ring(std::vector<MonitoredMutex<BreakableMutex>> &locks,
+               std::vector<std::thread> &threads) {
+    for (auto &lock : locks) {
+        lock.native().open();
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+// Thread i holds lock i, then waits up to `hold` for lock i + 1. The waits
+// time out, so the ring breaks up on its own.
+void lock_in_ring(std::vector<MonitoredMutex<std::timed_mutex>> &locks,
+                  std::chrono::milliseconds hold, std::vector<std::thread> &threads,
+                  std::atomic<int> &holding) {
+    int n = static_cast<int>(locks.size());
+    for (int i = 0; i < n; ++i) {
+        threads.emplace_back([&locks, &holding, i, n, hold]() {
+            std::lock_guard<MonitoredMutex<std::timed_mutex>> first(locks[i]);
+            holding.fetch_add(1);
+            while (holding.load() < n) {
+                std::this_thread::yield();
+            }
+            if (locks[(i + 1) % n].try_lock_for(hold)) {
+                locks[(i + 1) % n].unlock();
+            }
+        });
+    }
+}
+
+} // namespace
+
+TEST(LockMonitorTest, UncontendedLockingReportsNothing) {
+    MonitoredMutex<> a;
+    MonitoredMutex<> b;
+    for (int i = 0; i < 1000; ++i) {
+        std::scoped_lock lock(a, b);
+    }
+    auto report = LockMonitor::global().scan(0ns);
+    EXPECT_FALSE(involves(report, &a));
+    EXPECT_FALSE(involves(report, &b));
+    EXPECT_TRUE(report.starved.empty());
+}
+
+TEST(LockMonitorTest, DetectsTwoThreadCycle) {
+    std::vector<MonitoredMutex<BreakableMutex>> locks(2);
+    std::vector<std::thread> threads;
+    std::atomic<int> holding{0};
+    deadlock_ring(locks, threads, holding);
+
+    auto report = scan_until([&](const LockReport &r) { return involves(r, &locks[0]); });
+    ASSERT_TRUE(report.deadlocked());
+    for (const auto &cycle : report.cycles) {
+        if (involves(LockReport{{cycle}, {}}, &locks[0])) {
+            ASSERT_EQ(cycle.size(), 2u);
+            EXPECT_NE(cycle[0].thread, cycle[1].thread);
+            EXPECT_TRUE(involves(LockReport{{cycle}, {}}, &locks[1]));
+        }
+    }
+    open_ring(locks, threads);
+    EXPECT_FALSE(involves(LockMonitor::global().scan(), &locks[0]));
+}
+
+TEST(LockMonitorTest, DetectsLongerCycle) {
+    std::vector<MonitoredMutex<BreakableMutex>> locks(5);
+    std::vector<std::thread> threads;
+    std::atomic<int> holding{0};
+    deadlock_ring(locks, threads, holding);
+
+    auto report = scan_until([&](const LockReport &r) { return involves(r, &locks[0]); });
+    bool found = false;
+    for (const auto &cycle : report.cycles) {
+        if (involves(LockReport{{cycle}, {}}, &locks[0])) {
+            found = true;
+            EXPECT_EQ(cycle.size(), 5u);
+        }
+    }
+    EXPECT_TRUE(found);
+    open_ring(locks, threads);
+}
+
+TEST(LockMonitorTest, TimedWaitsAreNotCycles) {
+    std::vector<MonitoredMutex<std::timed_mutex>> locks(2);
+    std::vector<std::thread> threads;
+    std::atomic<int> holding{0};
+    lock_in_ring(locks, 300ms, threads, holding);
+
+    // Both threads sit in try_lock_for: starved, but never deadlocked
+    auto starved = [&](const LockReport &r) {
+        return std::any_of(r.starved.begin(), r.starved.end(),
+                           [&](const LockWait &w) { return w.lock == &locks[0]; });
+    };
+    EXPECT_TRUE(starved(scan_until(starved, 0ns)));
+    int cycles = 0;
+    auto deadline = std::chrono::steady_clock::now() + 100ms;
+    while (std::chrono::steady_clock::now() < deadline) {
+        cycles += involves(LockMonitor::global().scan(), &locks[0]);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(cycles, 0);
+}
+
+TEST(LockMonitorTest, ReportsStarvedWaiter) {
+    MonitoredMutex<> lock;
+    lock.lock();
+    std::thread waiter([&]() {
+        std::lock_guard<MonitoredMutex<>> guard(lock);
+    });
+
+    auto report = scan_until(
+        [&](const LockReport &r) {
+            return std::any_of(r.starved.begin(), r.starved.end(),
+                               [&](const LockWait &w) { return w.lock == &lock; });
+        },
+        20ms);
+    lock.unlock();
+    waiter.join();
+
+    auto it = std::find_if(report.starved.begin(), report.starved.end(),
+                           [&](const LockWait &w) { return w.lock == &lock; });
+    ASSERT_NE(it, report.starved.end());
+    EXPECT_GE(it->waited, 20ms);
+    EXPECT_FALSE(report.deadlocked());
+}
+
+TEST(LockMonitorTest, WriterBlockedByReadersIsStarved) {
+    MonitoredMutex<std::shared_mutex> shared;
+    MonitoredMutex<ReadWriteLock> read_write;
+    shared.lock_shared();
+    read_write.lock_read();
+    std::thread writer([&]() {
+        shared.lock();
+        shared.unlock();
+        read_write.lock_write();
+        read_write.unlock_write();
+    });
+
+    auto starved = [](const LockReport &r, const void *lock) {
+        return std::any_of(r.starved.begin(), r.starved.end(),
+                           [lock](const LockWait &w) { return w.lock == lock; });
+    };
+    EXPECT_TRUE(starved(scan_until([&](const LockReport &r) { return starved(r, &shared); },
+                                   10ms),
+                        &shared));
+    shared.unlock_shared();
+    EXPECT_TRUE(starved(
+        scan_until([&](const LockReport &r) { return starved(r, &read_write); }, 10ms),
+        &read_write));
+    read_write.unlock_read();
+    writer.join();
+}
+
+TEST(LockMonitorTest, SamplerCallsBackOnCycle) {
+    std::atomic<bool> seen{false};
+    std::vector<MonitoredMutex<BreakableMutex>> locks(2);
+    LockMonitor::global().start_sampler(5ms, 10s, [&](const LockReport &report) {
+        if (involves(report, &locks[0])) {
+            seen.store(true);
+        }
+    });
+    std::vector<std::thread> threads;
+    std::atomic<int> holding{0};
+    deadlock_ring(locks, threads, holding);
+    auto deadline = std::chrono::steady_clock::now() + 1500ms;
+    while (!seen.load() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    open_ring(locks, threads);
+    LockMonitor::global().stop_sampler();
+    EXPECT_TRUE(seen.load());
+    EXPECT_GT(LockMonitor::global().samples(), 0u);
+}
+
+TEST(LockMonitorTest, NoCyclesUnderOrderedLocking) {
+    constexpr int kLocks = 4;
+    std::vector<MonitoredMutex<>> locks(kLocks);
+    std::atomic<bool> running{true};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t]() {
+            int first = t % kLocks;
+            int second = (t + 1) % kLocks;
+            while (running.load()) {
+                std::lock_guard<MonitoredMutex<>> a(locks[std::min(first, second)]);
+                std::lock_guard<MonitoredMutex<>> b(locks[std::max(first, second)]);
+            }
+        });
+    }
+    auto deadline = std::chrono::steady_clock::now() + 300ms;
+    int cycles = 0;
+    while (std::chrono::steady_clock::now() < deadline) {
+        for (const auto &lock : locks) {
+            cycles += involves(LockMonitor::global().scan(), &lock);
+        }
+    }
+    running.store(false);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(cycles, 0);
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "map_reduce.hpp"
+
+using namespace concurrency;
+
+TEST(MapReduceTest, SumOfSquaresMatchesSerial) {
+    std::vector<long long> data(100000);
+    std::iota(data.begin(), data.end(), 0);
+
+    auto result = map_reduce(
+        data, [](long long x) { return x * x; },
+        [](long long a, long long b) { return a + b; }, 8);
+
+    long long expected = 0;
+    for (long long x : data) {
+        expected += x * x;
+    }
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, expected);
+}
+
+TEST(MapReduceTest, MergesNonTrivialAccumulators) {
+    std::vector<std::string> words;
+    for (int i = 0; i < 3000; ++i) {
+        words.push_back(i % 3 == 0 ? "a" : (i % 3 == 1 ? "b" : "c"));
+    }
+
+    using Counts = std::map<std::string, int>;
+    auto result = map_reduce(
+        words, [](const std::string &w) { return Counts{{w, 1}}; },
+        [](Counts a, Counts b) {
+            for (auto &[word, n] : b) {
+                a[word] += n;
+            }
+            return a;
+        },
+        5);
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ((*result)["a"], 1000);
+    EXPECT_EQ((*result)["b"], 1000);
+    EXPECT_EQ((*result)["c"], 1000);
+}
+
+TEST(MapReduceTest, MoreWorkersThanItems) {
+    std::vector<int> data{1, 2, 3};
+    auto result = map_reduce(
+        data, [](int x) { return x; }, [](int a, int b) { return a + b; }, 16);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 6);
+}
+
+TEST(MapReduceTest, EmptySourceGivesNoResult) {
+    std::vector<int> data;
+    auto result = map_reduce(
+        data, [](int x) { return x; }, [](int a, int b) { return a + b; }, 4);
+    EXPECT_FALSE(result.has_value());
+}
+
+TEST(MapReduceTest, RethrowsFirstExceptionAfterJoiningWorkers) {
+    std::vector<int> data(10000);
+    std::iota(data.begin(), data.end(), 0);
+
+    // Throws on whichever thread claims the chunk, including the caller
+    EXPECT_THROW(map_reduce(
+                     data,
+                     [](int x) {
+                         if (x == 4321) {
+                             throw std::runtime_error("bad item");
+                         }
+                         return x;
+                     },
+                     [](int a, int b) { return a + b; }, 8),
+                 std::runtime_error);
+
+    EXPECT_THROW(map_reduce(
+                     data, [](int x) { return x; },
+                     [](int a, int b) -> int {
+                         if (a + b > 1000000) {
+                             throw std::overflow_error("too big");
+                         }
+                         return a + b;
+                     },
+                     8),
+                 std::overflow_error);
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "pool_metrics.hpp"
+
+using namespace concurrency;
+using namespace std::chrono_literals;
+
+TEST(StripedCounterTest, SumsAcrossThreads) {
+    StripedCounter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 10000; ++i) {
+                counter.add();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    counter.add(5);
+    EXPECT_EQ(counter.load(), 80005);
+}
+
+TEST(LatencyHistogramTest, BucketsByPowerOfTwo) {
+    LatencyHistogram histogram;
+    histogram.record(0ns);
+    histogram.record(1ns);
+    histogram.record(1000ns);   // [512, 1024)
+    histogram.record(1024ns);   // [1024, 2048)
+    histogram.record(-5ns);     // Clamped to zero
+    histogram.record(std::chrono::hours(1000));  // Open-ended last bucket
+
+    auto snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count(), 6);
+    EXPECT_EQ(snapshot.buckets[0], 2);
+    EXPECT_EQ(snapshot.buckets[1], 1);
+    EXPECT_EQ(snapshot.buckets[10], 1);
+    EXPECT_EQ(snapshot.buckets[11], 1);
+    EXPECT_EQ(snapshot.buckets[LatencyHistogram::kBuckets - 1], 1);
+}
+
+TEST(LatencyHistogramTest, PercentilesAreBucketUpperBounds) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.snapshot().percentile(0.99), 0ns);
+
+    for (int i = 0; i < 99; ++i) {
+        histogram.record(100ns);  // [64, 128)
+    }
+    histogram.record(1ms);
+    auto snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.percentile(0.5), 128ns);
+    EXPECT_EQ(snapshot.percentile(0.99), 128ns);
+    EXPECT_GE(snapshot.percentile(1.0), 1ms);
+    EXPECT_LT(snapshot.percentile(1.0), 2ms + 100us);
+}
@@ -90,4 +90,134 @@ TEST_F(ProducerConsumerTest, BufferBounds) {
     // Buffer should have reached capacity
     EXPECT_TRUE(buffer_full_detected.load());
     EXPECT_LE(max_buffer_size.load(), 10); // Should not exceed buffer size
-}
\ No newline at end of file
+}
+
+TEST_F(ProducerConsumerTest, ExpiredItemsAreShed) {
+    std::atomic<int> next_item{0};
+    std::atomic<int> odd_consumed{0};
+
+    // Odd items arrive already past their deadline
+    pc.set_deadline([](const int &item) {
+        return item % 2 ? ProducerConsumer<int>::Clock::time_point::min()
+                        : ProducerConsumer<int>::Clock::time_point::max();
+    });
+
+    auto producer_func = [&]() -> int { return next_item.fetch_add(1); };
+    auto consumer_func = [&](int item) {
+        if (item % 2) {
+            odd_consumed.fetch_add(1);
+        }
+    };
+
+    pc.start(1, 1, producer_func, consumer_func);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    pc.stop();
+
+    EXPECT_EQ(odd_consumed.load(), 0);
+    EXPECT_GT(pc.items_expired(), 0);
+    EXPECT_EQ(pc.items_dropped(), 0);
+    EXPECT_EQ(pc.items_produced(), pc.items_consumed() + pc.items_shed());
+}
+
+TEST_F(ProducerConsumerTest, CoDelBoundsQueueDelay) {
+    ProducerConsumer<int> slow{50};
+    slow.enable_codel(std::chrono::milliseconds(1),
+                      std::chrono::milliseconds(10));
+
+    auto producer_func = [&]() -> int { return 1; };
+    auto consumer_func = [&](int) {
+        // Consumer far slower than producer: a standing queue builds up
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    };
+
+    slow.start(2, 1, producer_func, consumer_func);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    slow.stop();
+
+    EXPECT_GT(slow.items_dropped(), 0);
+    EXPECT_GT(slow.items_consumed(), 0);
+    EXPECT_EQ(slow.items_produced(), slow.items_consumed() + slow.items_shed());
+}
+
+TEST_F(ProducerConsumerTest, CoalescesPendingItemsByKey) {
+    // Item = {key, number of updates folded into it}
+    using Update = std::pair<int, int>;
+    ProducerConsumer<Update> coalescing{10};
+    coalescing.enable_coalescing(
+        [](const Update &u) { return u.first; },
+        [](Update &pending, Update &&incoming) {
+            pending.second += incoming.second;
+        });
+
+    std::atomic<int> next_key{0};
+    std::atomic<int> updates_seen{0};
+    std::atomic<size_t> max_buffered{0};
+
+    auto producer_func = [&]() -> Update {
+        return {next_key.fetch_add(1) % 4, 1};
+    };
+    auto consumer_func = [&](Update u) {
+        updates_seen.fetch_add(u.second);
+        size_t buffered = coalescing.current_buffer_size();
+        size_t seen_max = max_buffered.load();
+        while (buffered > seen_max &&
+               !max_buffered.compare_exchange_weak(seen_max, buffered)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    };
+
+    coalescing.start(2, 1, producer_func, consumer_func);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    coalescing.stop();
+
+    // Only 4 keys exist, so at most 4 items can ever be pending
+    EXPECT_LE(max_buffered.load(), 4);
+    EXPECT_GT(coalescing.items_coalesced(), 0);
+    EXPECT_EQ(static_cast<size_t>(updates_seen.load()),
+              coalescing.items_produced());
+}
+
+TEST_F(ProducerConsumerTest, RateLimitedConsumers) {
+    // 100/s shared by four consumers, burst of 5
+    pc.set_rate_limiter(std::make_shared<RateLimiter>(100.0, 5));
+
+    auto producer_func = [&]() -> int { return 1; };
+    auto consumer_func = [&](int) {};
+
+    auto start = std::chrono::steady_clock::now();
+    pc.start(1, 4, producer_func, consumer_func);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    size_t consumed = pc.items_consumed();
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start);
+    pc.stop();
+
+    double allowed = 100.0 * elapsed.count() + 5 + 1;
+    EXPECT_GT(consumed, 15);
+    EXPECT_LE(static_cast<double>(consumed), allowed);
+    // No burst on stop: the leftover buffer is dropped, not drained
+    elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_LE(static_cast<double>(pc.items_consumed()), 100.0 * elapsed.count() + 5 + 1);
+    EXPECT_EQ(pc.items_consumed() + pc.items_dropped(), pc.items_produced());
+}
+
+TEST_F(ProducerConsumerTest, StopInterruptsRateLimitWait) {
+    // One permit every 10 s: after the burst, consumers wait on the limiter
+    pc.set_rate_limiter(std::make_shared<RateLimiter>(0.1, 1));
+
+    auto producer_func = [&]() -> int { return 1; };
+    auto consumer_func = [&](int) {};
+
+    pc.start(1, 2, producer_func, consumer_func);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto before_stop = std::chrono::steady_clock::now();
+    pc.stop();
+    auto stop_time = std::chrono::steady_clock::now() - before_stop;
+
+    EXPECT_LT(stop_time, std::chrono::seconds(2));
+    // Only the burst went downstream; the full buffer was dropped on stop
+    EXPECT_EQ(pc.current_buffer_size(), 0);
+    EXPECT_LE(pc.items_consumed(), 1);
+    EXPECT_GT(pc.items_dropped(), 0);
+    EXPECT_EQ(pc.items_consumed() + pc.items_dropped(), pc.items_produced());
+}
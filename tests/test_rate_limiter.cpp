@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "rate_limiter.hpp"
+
+using namespace concurrency;
+
+TEST(RateLimiterTest, BurstThenRefuse) {
+    RateLimiter limiter(10.0, 3);
+
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_FALSE(limiter.try_acquire());
+
+    // One permit refills every 100ms
+    std::this_thread::sleep_for(std::chrono::milliseconds(110));
+    EXPECT_TRUE(limiter.try_acquire());
+    EXPECT_FALSE(limiter.try_acquire());
+}
+
+TEST(RateLimiterTest, BlockingAcquirePacesSharedThreads) {
+    RateLimiter limiter(200.0, 1);
+    const int num_threads = 4;
+    const int permits_per_thread = 10;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < permits_per_thread; ++j) {
+                limiter.acquire();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // 40 permits at 200/s: the first is free, the rest are 5ms apart
+    EXPECT_GE(elapsed, std::chrono::milliseconds(190));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(400));
+}
+
+TEST(RateLimiterTest, RejectsInvalidConfiguration) {
+    EXPECT_THROW(RateLimiter(0.0), std::invalid_argument);
+    EXPECT_THROW(RateLimiter(10.0, 0), std::invalid_argument);
+}
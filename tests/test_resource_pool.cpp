@@ -3,7 +3,12 @@
 #include <chrono>
 #include <vector>
 #include <atomic>
+#include <functional>
+#include "coroutine_scheduler.hpp"
 #include "resource_pool.hpp"
+#ifdef __linux__
+#include <pthread.h>
+#endif
 
 using namespace concurrency;
 
@@ -167,4 +172,738 @@ TEST_F(ResourcePoolTest, SemaphoreBlocking) {
     for (size_t i = 1; i < resources.size(); ++i) {
         pool.release(resources[i]);
     }
-}
\ No newline at end of file
+}
+
+TEST_F(ResourcePoolTest, ThreadCacheReusesResourceLocally) {
+    pool.enable_thread_cache(1);
+
+    auto first = pool.acquire();
+    MockConnection *raw = first.get();
+    pool.release(std::move(first));
+
+    // Parked in this thread's cache: still counted as in use by the pool
+    EXPECT_EQ(pool.available_count(), 2);
+    EXPECT_EQ(pool.current_usage(), 1);
+
+    auto again = pool.acquire();
+    EXPECT_EQ(again.get(), raw);
+    // Cache hits and parks still show up in the counters
+    EXPECT_EQ(pool.total_acquisitions(), 2);
+    EXPECT_EQ(pool.total_releases(), 1);
+
+    // Second release overflows past the one-slot cache
+    auto other = pool.acquire();
+    pool.release(again);
+    pool.release(other);
+    EXPECT_EQ(pool.available_count(), 2);
+
+    pool.flush_thread_cache();
+    EXPECT_EQ(pool.available_count(), 3);
+    EXPECT_EQ(pool.current_usage(), 0);
+}
+
+TEST_F(ResourcePoolTest, ThreadCacheReclaimedOnThreadExit) {
+    pool.enable_thread_cache(2);
+
+    std::thread worker([&]() {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        pool.release(a);
+        pool.release(b);
+        EXPECT_EQ(pool.available_count(), 1);
+    });
+    worker.join();
+
+    EXPECT_EQ(pool.available_count(), 3);
+    EXPECT_EQ(pool.current_usage(), 0);
+}
+
+TEST_F(ResourcePoolTest, ThreadCacheCountsOutliveThread) {
+    pool.enable_thread_cache(1);
+
+    // Counted in the worker's own counters, kept when it exits
+    std::thread worker([&]() {
+        for (int i = 0; i < 10; ++i) {
+            pool.release(pool.acquire());
+        }
+        EXPECT_EQ(pool.total_acquisitions(), 10);
+    });
+    worker.join();
+
+    EXPECT_EQ(pool.total_acquisitions(), 10);
+    EXPECT_EQ(pool.total_releases(), 10);
+    pool.release(pool.acquire());
+    EXPECT_EQ(pool.total_acquisitions(), 11);
+}
+
+TEST_F(ResourcePoolTest, ParkedResourcesAreStolenByWaiters) {
+    pool.enable_thread_cache(3);
+    std::atomic<bool> parked{false};
+    std::atomic<bool> done{false};
+
+    // Parks the whole pool in its cache, then idles without flushing
+    std::thread idler([&]() {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        auto c = pool.acquire();
+        pool.release(a);
+        pool.release(b);
+        pool.release(c);
+        parked = true;
+        parked.notify_one();
+        done.wait(false);
+    });
+    parked.wait(false);
+
+    auto first = pool.try_acquire(std::chrono::milliseconds(100));
+    ASSERT_TRUE(first != nullptr);
+    auto async = pool.acquire_async();
+    auto second = async.get_for(std::chrono::milliseconds(100));
+    ASSERT_TRUE(second);
+    auto deadline = ResourcePool<MockConnection>::Clock::now() +
+                    std::chrono::milliseconds(100);
+    auto third = pool.acquire_handle(AcquirePriority::Normal, deadline);
+    ASSERT_TRUE(third);
+
+    second.reset();
+    third.reset();
+    pool.release(first);
+    done = true;
+    done.notify_one();
+    idler.join();
+    EXPECT_EQ(pool.current_usage(), 0);
+    EXPECT_EQ(pool.available_count(), 3);
+}
+
+TEST(ResourcePoolThreadCacheTest, CachesNeverStarveOtherThreads) {
+    ResourcePool<MockConnection> pool(3);
+    pool.enable_thread_cache(2);
+    std::atomic<int> timeouts{0};
+
+    // More threads than resources, each able to park two of them
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 500; ++j) {
+                auto resource = pool.try_acquire(std::chrono::seconds(5));
+                if (!resource) {
+                    timeouts.fetch_add(1);
+                    continue;
+                }
+                pool.release(std::move(resource));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(timeouts.load(), 0);
+    EXPECT_EQ(pool.total_acquisitions(), 8 * 500);
+}
+
+TEST(ResourcePoolThreadCacheTest, ThreadMayOutliveCachedPool) {
+    auto pool = std::make_unique<ResourcePool<MockConnection>>(2);
+    pool->enable_thread_cache(1);
+    std::atomic<bool> cached{false};
+    std::atomic<bool> pool_gone{false};
+
+    std::thread worker([&]() {
+        pool->release(pool->acquire());
+        cached = true;
+        cached.notify_one();
+        pool_gone.wait(false);
+    }); // Cache is flushed here, after the pool was destroyed
+
+    cached.wait(false);
+    pool.reset();
+    pool_gone = true;
+    pool_gone.notify_one();
+    worker.join();
+    SUCCEED();
+}
+
+TEST(ResourcePoolLockFreeTest, ExclusiveOwnershipUnderContention) {
+    const int pool_size = 4;
+    ResourcePool<MockConnection> pool(pool_size, FreeListKind::LockFreeStack);
+    std::vector<std::atomic<bool>> in_use(pool_size);
+    std::atomic<int> violations{0};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 2000; ++j) {
+                auto resource = pool.acquire();
+                if (in_use[resource->id].exchange(true)) {
+                    violations.fetch_add(1);
+                }
+                in_use[resource->id].store(false);
+                pool.release(std::move(resource));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(violations.load(), 0);
+    EXPECT_EQ(pool.current_usage(), 0);
+    EXPECT_EQ(pool.available_count(), pool_size);
+    EXPECT_LE(pool.peak_usage(), pool_size);
+}
+
+TEST(ResourcePoolLockFreeTest, TimeoutWhenExhausted) {
+    ResourcePool<MockConnection> pool(2, FreeListKind::LockFreeStack);
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    EXPECT_EQ(pool.available_count(), 0);
+    EXPECT_FALSE(pool.try_acquire(std::chrono::milliseconds(20)));
+
+    pool.release(a);
+    auto c = pool.try_acquire(std::chrono::milliseconds(20));
+    ASSERT_TRUE(c != nullptr);
+    EXPECT_EQ(c.get(), a.get());
+    pool.release(b);
+    pool.release(c);
+}
+
+TEST(ResourcePoolLockFreeTest, RejectsForeignResource) {
+    ResourcePool<MockConnection> pool(1, FreeListKind::LockFreeStack);
+    EXPECT_THROW(pool.release(std::make_shared<MockConnection>(7)),
+                 std::invalid_argument);
+}
+
+TEST(ResourcePoolReuseOrderTest, FifoRotatesThroughResources) {
+    ResourcePool<MockConnection> pool(3, FreeListKind::FifoQueue);
+    std::vector<int> ids;
+    for (int i = 0; i < 3; ++i) {
+        auto resource = pool.acquire();
+        ids.push_back(resource->id);
+        pool.release(resource);
+    }
+    EXPECT_EQ(ids, (std::vector<int>{0, 1, 2}));
+}
+
+TEST(ResourcePoolReuseOrderTest, LifoReusesMostRecentlyReleased) {
+    for (auto kind : {FreeListKind::LifoStack, FreeListKind::LockFreeStack}) {
+        ResourcePool<MockConnection> pool(3, kind);
+
+        // A single borrower keeps getting the same warm resource
+        for (int i = 0; i < 3; ++i) {
+            auto resource = pool.acquire();
+            EXPECT_EQ(resource->id, 0);
+            pool.release(resource);
+        }
+
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        pool.release(a);
+        pool.release(b);
+        auto next = pool.acquire();
+        EXPECT_EQ(next.get(), b.get());
+        pool.release(next);
+        EXPECT_EQ(pool.available_count(), 3);
+    }
+}
+
+TEST_F(ResourcePoolTest, HandleReleasesOnDestruction) {
+    {
+        auto handle = pool.acquire_handle();
+        ASSERT_TRUE(handle);
+        EXPECT_EQ(handle->id, 0);
+        EXPECT_EQ(handle.index(), 0u);
+        EXPECT_EQ(pool.current_usage(), 1);
+
+        // Moving transfers ownership without releasing
+        auto moved = std::move(handle);
+        EXPECT_FALSE(handle);
+        EXPECT_TRUE(moved);
+        EXPECT_EQ(pool.current_usage(), 1);
+    }
+    EXPECT_EQ(pool.current_usage(), 0);
+    EXPECT_EQ(pool.available_count(), 3);
+}
+
+TEST_F(ResourcePoolTest, HandleGenerationAdvancesPerBorrow) {
+    ResourcePool<MockConnection> lifo(1, FreeListKind::LifoStack);
+    auto first = lifo.acquire_handle();
+    uint32_t first_generation = first.generation();
+    first.reset();
+    EXPECT_FALSE(first);
+
+    auto second = lifo.acquire_handle();
+    EXPECT_EQ(second.index(), 0u);
+    EXPECT_NE(second.generation(), first_generation);
+
+    auto timed_out = lifo.try_acquire_handle(std::chrono::milliseconds(10));
+    EXPECT_FALSE(timed_out);
+}
+
+TEST_F(ResourcePoolTest, ResourcesAreContiguous) {
+    auto a = pool.acquire_handle();
+    auto b = pool.acquire_handle();
+    auto c = pool.acquire_handle();
+    EXPECT_EQ(b.get(), a.get() + 1);
+    EXPECT_EQ(c.get(), a.get() + 2);
+    EXPECT_EQ(sizeof(a), sizeof(void *) + 2 * sizeof(uint32_t));
+}
+
+TEST_F(ResourcePoolTest, AsyncAcquireHandsOffOnRelease) {
+    auto a = pool.acquire_handle();
+    auto b = pool.acquire_handle();
+    auto c = pool.acquire_handle();
+
+    auto first = pool.acquire_async();
+    auto second = pool.acquire_async();
+    EXPECT_FALSE(first.ready());
+
+    uint32_t released = b.index();
+    b.reset();
+    // Handed straight to the oldest waiter, never visible as free
+    EXPECT_TRUE(first.ready());
+    EXPECT_FALSE(second.ready());
+    EXPECT_EQ(pool.available_count(), 0);
+
+    auto handle = first.get();
+    ASSERT_TRUE(handle);
+    EXPECT_EQ(handle.index(), released);
+
+    a.reset();
+    EXPECT_TRUE(second.ready());
+    EXPECT_TRUE(second.get());
+}
+
+TEST_F(ResourcePoolTest, AsyncAcquireTimeoutAndCancelDoNotLeak) {
+    std::vector<PoolHandle<MockConnection>> held;
+    for (int i = 0; i < 3; ++i) {
+        held.push_back(pool.acquire_handle());
+    }
+
+    auto timed = pool.acquire_async();
+    EXPECT_FALSE(timed.get_for(std::chrono::milliseconds(20)));
+
+    auto cancelled = pool.acquire_async();
+    cancelled.cancel();
+    EXPECT_FALSE(cancelled.get());
+
+    {
+        // Completed but never taken: returned when the request is dropped
+        auto untaken = pool.acquire_async();
+        held.pop_back();
+        EXPECT_TRUE(untaken.ready());
+        EXPECT_EQ(pool.available_count(), 0);
+    }
+
+    held.clear();
+    EXPECT_EQ(pool.available_count(), 3);
+    EXPECT_EQ(pool.current_usage(), 0);
+}
+
+TEST_F(ResourcePoolTest, AsyncAcquireResumesCoroutine) {
+    auto held = pool.acquire_handle();
+    auto held2 = pool.acquire_handle();
+    auto held3 = pool.acquire_handle();
+    std::atomic<int> got_id{-1};
+
+    auto borrower = [&]() -> DetachedTask {
+        auto handle = co_await pool.acquire_async();
+        got_id = handle ? handle->id : -2;
+    };
+    borrower();  // Suspends: pool exhausted
+    EXPECT_EQ(got_id.load(), -1);
+
+    int expected = held2->id;
+    held2.reset();  // Posts the coroutine to the pool's worker thread
+    while (got_id.load() == -1) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(got_id.load(), expected);
+    EXPECT_EQ(pool.current_usage(), 2);
+}
+
+TEST_F(ResourcePoolTest, AsyncAcquireResumesOnExecutor) {
+    CoroutineScheduler scheduler(1);
+    pool.set_executor([&](std::coroutine_handle<> h) { scheduler.post(h); });
+    auto held = pool.acquire_handle();
+    auto held2 = pool.acquire_handle();
+    auto held3 = pool.acquire_handle();
+    std::atomic<bool> resumed_here{true};
+    std::atomic<bool> done{false};
+
+    auto releaser = std::this_thread::get_id();
+    auto borrower = [&]() -> DetachedTask {
+        auto handle = co_await pool.acquire_async();
+        resumed_here = std::this_thread::get_id() == releaser;
+        handle.reset();
+        done = true;
+        done.notify_one();
+    };
+    borrower();
+
+    held.reset();
+    done.wait(false);
+    EXPECT_FALSE(resumed_here.load());
+    EXPECT_EQ(pool.total_acquisitions(), 4);
+    EXPECT_EQ(pool.total_releases(), 2);
+}
+
+TEST(ResourcePoolShutdownTest, DestructorDrainsResumedCoroutines) {
+    std::atomic<int> finished{0};
+    {
+        ResourcePool<MockConnection> pool{1};
+        auto held = pool.acquire_handle();
+        auto borrower = [&]() -> DetachedTask {
+            auto handle = co_await pool.acquire_async();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            handle.reset();  // Hands off to the next borrower
+            finished.fetch_add(1);
+        };
+        borrower();
+        borrower();
+        held.reset();  // Pool is destroyed while the first one sleeps
+    }
+    EXPECT_EQ(finished.load(), 2);
+}
+
+TEST_F(ResourcePoolTest, AsyncWaitersConcurrentWithBlockingAcquire) {
+    std::atomic<int> completed{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 6; ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < 200; ++j) {
+                if (i % 2) {
+                    auto handle = pool.acquire_async().get();
+                    ASSERT_TRUE(handle);
+                } else {
+                    ResourceGuard<MockConnection> guard(pool);
+                    ASSERT_TRUE(guard.valid());
+                }
+                completed.fetch_add(1);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(completed.load(), 1200);
+    EXPECT_EQ(pool.current_usage(), 0);
+    EXPECT_EQ(pool.available_count(), 3);
+}
+
+TEST_F(ResourcePoolTest, HigherPriorityWaitersServedFirst) {
+    std::vector<ResourcePool<MockConnection>::Handle> held;
+    for (int i = 0; i < 3; ++i) {
+        held.push_back(pool.acquire_handle());
+    }
+    auto low = pool.acquire_async(AcquirePriority::Low);
+    auto normal = pool.acquire_async(AcquirePriority::Normal);
+    auto high = pool.acquire_async(AcquirePriority::High);
+    auto high2 = pool.acquire_async(AcquirePriority::High);
+
+    held.pop_back();
+    EXPECT_TRUE(high.ready());
+    EXPECT_FALSE(high2.ready());
+    held.pop_back();
+    EXPECT_TRUE(high2.ready());  // FIFO within a class
+    held.pop_back();
+    EXPECT_TRUE(normal.ready());
+    EXPECT_FALSE(low.ready());
+
+    normal.get().reset();
+    EXPECT_TRUE(low.ready());
+}
+
+TEST_F(ResourcePoolTest, ExpiredWaitersAreSkipped) {
+    auto held = pool.acquire_handle();
+    auto held2 = pool.acquire_handle();
+    auto held3 = pool.acquire_handle();
+    auto now = ResourcePool<MockConnection>::Clock::now();
+    auto expired = pool.acquire_async(AcquirePriority::High, now);
+    auto live = pool.acquire_async(AcquirePriority::Normal,
+                                   now + std::chrono::seconds(10));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    held.reset();
+    EXPECT_TRUE(expired.ready());
+    EXPECT_FALSE(expired.get());
+    EXPECT_TRUE(live.ready());
+    auto taken = live.get();
+    EXPECT_TRUE(taken);
+
+    // Blocking form gives up at its deadline
+    auto start = std::chrono::steady_clock::now();
+    auto timed_out = pool.acquire_handle(
+        AcquirePriority::High, start + std::chrono::milliseconds(20));
+    EXPECT_FALSE(timed_out);
+    EXPECT_GE(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(20));
+}
+
+TEST_F(ResourcePoolTest, ExpiredWaitersLeaveQueueAtDeadline) {
+    auto held = pool.acquire_handle();
+    auto held2 = pool.acquire_handle();
+    auto held3 = pool.acquire_handle();
+    auto deadline = ResourcePool<MockConnection>::Clock::now() +
+                    std::chrono::milliseconds(20);
+    auto request = pool.acquire_async(AcquirePriority::Normal, deadline);
+    EXPECT_EQ(pool.waiting_count(), 1);
+
+    // No release happens, yet the request still completes at its deadline
+    auto result = request.get();
+    EXPECT_FALSE(result);
+    EXPECT_EQ(pool.waiting_count(), 0);
+    EXPECT_EQ(pool.total_timeouts(), 1);
+}
+
+TEST(ResourcePoolAgingTest, LongWaitingLowPriorityOvertakesHigh) {
+    ResourcePool<MockConnection> pool(1);
+    pool.set_priority_aging(std::chrono::milliseconds(10));
+    auto held = pool.acquire_handle();
+
+    auto low = pool.acquire_async(AcquirePriority::Low);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    auto high = pool.acquire_async(AcquirePriority::High);
+
+    held.reset();
+    EXPECT_TRUE(low.ready());  // Aged to High and arrived first
+    EXPECT_FALSE(high.ready());
+    low.get().reset();
+    EXPECT_TRUE(high.ready());
+}
+
+TEST(ResourcePoolFairnessTest, BlockedThreadsServedInArrivalOrder) {
+    ResourcePool<MockConnection> pool(1);
+    pool.enable_fair_queueing();
+    auto held = pool.acquire_handle();
+
+    std::mutex order_mutex;
+    std::vector<int> order;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 5; ++i) {
+        threads.emplace_back([&, i]() {
+            auto conn = pool.acquire();
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(i);
+            pool.release(conn);
+        });
+        // Let thread i queue up before thread i + 1 starts
+        while (pool.waiting_count() != static_cast<size_t>(i + 1)) {
+            std::this_thread::yield();
+        }
+    }
+    held.reset();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(pool.available_count(), 1);
+}
+
+TEST_F(ResourcePoolTest, AcquireNTakesAllOrNothing) {
+    EXPECT_THROW(pool.acquire_n(0), std::invalid_argument);
+    EXPECT_THROW(pool.acquire_n(4), std::invalid_argument);
+
+    {
+        auto batch = pool.acquire_n(2);
+        ASSERT_EQ(batch.size(), 2);
+        EXPECT_NE(batch[0].id, batch[1].id);
+        EXPECT_EQ(pool.current_usage(), 2);
+    }
+    EXPECT_EQ(pool.current_usage(), 0);
+    {
+        auto single = pool.acquire_n(1);
+        ASSERT_EQ(single.size(), 1);
+        EXPECT_EQ(pool.current_usage(), 1);
+    }
+    EXPECT_EQ(pool.current_usage(), 0);
+
+    // Timed out with one of three collected: the partial set goes back
+    auto held = pool.acquire_handle();
+    auto batch = pool.try_acquire_n(3, std::chrono::milliseconds(30));
+    EXPECT_FALSE(batch);
+    EXPECT_EQ(pool.current_usage(), 1);
+    EXPECT_EQ(pool.available_count(), 2);
+    EXPECT_EQ(pool.waiting_count(), 0);
+}
+
+TEST_F(ResourcePoolTest, LargeBatchNotStarvedBySingles) {
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> singles;
+    for (int i = 0; i < 4; ++i) {
+        singles.emplace_back([&]() {
+            while (!stop.load()) {
+                auto handle = pool.acquire_async().get();
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    auto batch = pool.try_acquire_n(3, std::chrono::seconds(5));
+    EXPECT_EQ(batch.size(), 3);
+    batch.reset();
+    stop = true;
+    for (auto &thread : singles) {
+        thread.join();
+    }
+    EXPECT_EQ(pool.current_usage(), 0);
+}
+
+TEST(ResourcePoolBatchTest, ConcurrentBatchesDoNotDeadlock) {
+    ResourcePool<MockConnection> pool(4);
+    std::atomic<int> completed{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 6; ++i) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < 200; ++j) {
+                auto batch = pool.acquire_n(2 + i % 3);
+                ASSERT_EQ(batch.size(), static_cast<size_t>(2 + i % 3));
+                completed.fetch_add(1);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(completed.load(), 1200);
+    EXPECT_EQ(pool.current_usage(), 0);
+    EXPECT_EQ(pool.available_count(), 4);
+}
+
+TEST_F(ResourcePoolTest, TryAcquireUpdatesPeakAndCountsTimeouts) {
+    auto a = pool.try_acquire(std::chrono::milliseconds(10));
+    auto b = pool.try_acquire(std::chrono::milliseconds(10));
+    auto c = pool.try_acquire_handle(std::chrono::milliseconds(10));
+    EXPECT_EQ(pool.peak_usage(), 3);
+
+    EXPECT_FALSE(pool.try_acquire(std::chrono::milliseconds(5)));
+    EXPECT_FALSE(pool.try_acquire_n(2, std::chrono::milliseconds(5)));
+    EXPECT_FALSE(pool.acquire_async().get_for(std::chrono::milliseconds(5)));
+    EXPECT_EQ(pool.total_timeouts(), 3);
+    pool.release(a);
+    pool.release(b);
+}
+
+TEST_F(ResourcePoolTest, TryTakeNeitherWaitsNorCountsMisses) {
+    auto a = pool.try_take_handle();
+    auto b = pool.try_take_handle();
+    auto c = pool.try_take_handle();
+    ASSERT_TRUE(a && b && c);
+    EXPECT_FALSE(pool.try_take_handle());
+    EXPECT_EQ(pool.total_timeouts(), 0);
+    EXPECT_EQ(pool.total_acquisitions(), 3);
+
+    b.reset();
+    auto again = pool.try_take_handle();
+    EXPECT_TRUE(again);
+    EXPECT_EQ(pool.current_usage(), 3);
+}
+
+TEST(ResourcePoolMetricsTest, RecordsWaitHoldAndUtilization) {
+    ResourcePool<MockConnection> pool(2);
+    pool.enable_metrics(std::chrono::milliseconds(5));
+
+    auto first = pool.acquire_handle();
+    std::thread waiter([&]() {
+        auto second = pool.acquire_handle();
+        auto third = pool.acquire_handle();  // Waits for `first`
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    first.reset();
+    waiter.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    auto metrics = pool.metrics();
+    EXPECT_EQ(metrics.capacity, 2);
+    EXPECT_EQ(metrics.in_use, 0);
+    EXPECT_EQ(metrics.peak_usage, 2);
+    EXPECT_EQ(metrics.acquisitions, 3);
+    EXPECT_EQ(metrics.releases, 3);
+    EXPECT_EQ(metrics.timeouts, 0);
+
+    EXPECT_EQ(metrics.wait_time.count(), 3);
+    EXPECT_GE(metrics.wait_time.percentile(1.0), std::chrono::milliseconds(10));
+    EXPECT_EQ(metrics.hold_time.count(), 3);
+    EXPECT_GE(metrics.hold_time.percentile(1.0), std::chrono::milliseconds(20));
+
+    ASSERT_FALSE(metrics.utilization.empty());
+    size_t busiest = 0;
+    for (const auto &sample : metrics.utilization) {
+        busiest = std::max(busiest, sample.peak_in_use);
+    }
+    EXPECT_EQ(busiest, 2);
+    EXPECT_EQ(metrics.utilization.back().in_use, 0);
+}
+
+#ifdef __linux__
+// Run `fn` on a thread pinned to `cpu`; false if pinning isn't allowed
+static bool run_pinned(int cpu, const std::function<void()> &fn) {
+    bool pinned = false;
+    std::thread thread([&]() {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+        if (pinned) {
+            fn();
+        }
+    });
+    thread.join();
+    return pinned;
+}
+
+TEST(ResourcePoolAffinityTest, PrefersResourceLastUsedOnSameCpu) {
+    ResourcePool<MockConnection> pool(8, FreeListKind::CpuAffinity);
+    bool pinned = run_pinned(0, [&]() {
+        auto first = pool.acquire_handle();
+        int id = first->id;
+        first.reset();  // Back onto CPU 0's stack
+        for (int i = 0; i < 10; ++i) {
+            auto again = pool.acquire_handle();
+            EXPECT_EQ(again->id, id);
+        }
+    });
+    if (!pinned) {
+        GTEST_SKIP() << "cannot pin threads here";
+    }
+    EXPECT_GE(pool.affinity_hits(), 10);
+}
+
+TEST(ResourcePoolAffinityTest, FallsBackToOtherCpusWithoutBlocking) {
+    ResourcePool<MockConnection> pool(4, FreeListKind::CpuAffinity);
+    bool pinned = run_pinned(0, [&]() {
+        // Takes every resource, most of them from other CPUs' stacks
+        std::vector<ResourcePool<MockConnection>::Handle> held;
+        for (int i = 0; i < 4; ++i) {
+            held.push_back(pool.try_acquire_handle(std::chrono::milliseconds(0)));
+            ASSERT_TRUE(held.back());
+        }
+        EXPECT_FALSE(pool.try_acquire_handle(std::chrono::milliseconds(0)));
+    });
+    if (!pinned) {
+        GTEST_SKIP() << "cannot pin threads here";
+    }
+    EXPECT_EQ(pool.current_usage(), 0);
+    EXPECT_EQ(pool.total_acquisitions(), 4);
+}
+#endif
+
+TEST(ResourcePoolAffinityTest, ExclusiveOwnershipUnderContention) {
+    ResourcePool<MockConnection> pool(4, FreeListKind::CpuAffinity);
+    std::vector<std::atomic<int>> owners(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 1000; ++i) {
+                auto handle = pool.acquire_handle();
+                EXPECT_EQ(owners[handle->id].fetch_add(1), 0);
+                owners[handle->id].fetch_sub(1);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(pool.current_usage(), 0);
+    EXPECT_EQ(pool.affinity_hits() + pool.affinity_misses(), 8000);
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+#include "sharded_resource_pool.hpp"
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+using namespace concurrency;
+
+struct ShardedConnection {
+    int id;
+    std::atomic<int> borrowers{0};
+
+    explicit ShardedConnection(int connection_id) : id(connection_id) {}
+};
+
+TEST(ShardedResourcePoolTest, PartitionsResourcesAcrossShards) {
+    ShardedResourcePool<ShardedConnection> pool(10, 4);
+    EXPECT_EQ(pool.num_shards(), 4);
+    EXPECT_EQ(pool.size(), 10);
+    EXPECT_EQ(pool.available_count(), 10);
+
+    std::vector<ShardedResourcePool<ShardedConnection>::Handle> held;
+    std::set<int> ids;
+    for (int i = 0; i < 10; ++i) {
+        held.push_back(pool.acquire_handle());
+        ids.insert(held.back()->id);
+    }
+    EXPECT_EQ(ids.size(), 10);  // Ids are unique across shards
+    EXPECT_EQ(*ids.begin(), 0);
+    EXPECT_EQ(*ids.rbegin(), 9);
+    EXPECT_EQ(pool.current_usage(), 10);
+    EXPECT_EQ(pool.peak_usage(), 10);
+
+    held.clear();
+    EXPECT_EQ(pool.current_usage(), 0);
+    EXPECT_EQ(pool.total_acquisitions(), 10);
+    EXPECT_EQ(pool.total_releases(), 10);
+}
+
+TEST(ShardedResourcePoolTest, HomeShardFirstThenSteals) {
+    ShardedResourcePool<ShardedConnection> pool(4, 2);
+    std::thread thread([&]() {
+#ifdef __linux__
+        // Stay on one CPU so the home shard can't change mid-test
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(sched_getcpu(), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+        size_t home = pool.home_shard();
+
+        auto first = pool.acquire_handle();
+        auto second = pool.acquire_handle();
+        EXPECT_EQ(first.shard(), home);
+        EXPECT_EQ(second.shard(), home);
+        EXPECT_EQ(pool.total_steals(), 0);
+
+        auto stolen = pool.acquire_handle();
+        EXPECT_NE(stolen.shard(), home);
+        EXPECT_EQ(pool.total_steals(), 1);
+    });
+    thread.join();
+}
+
+#ifdef __linux__
+TEST(ShardedResourcePoolTest, HomeShardFollowsCurrentCpu) {
+    ShardedResourcePool<ShardedConnection> pool(4, 2);
+    size_t cpus = std::thread::hardware_concurrency();
+    if (cpus < 2) {
+        GTEST_SKIP() << "needs two CPUs";
+    }
+    std::vector<size_t> homes;
+    std::thread thread([&]() {
+        for (int cpu = 0; cpu < 2; ++cpu) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+                return;
+            }
+            homes.push_back(pool.home_shard());  // Same thread, migrated
+        }
+    });
+    thread.join();
+    if (homes.size() < 2) {
+        GTEST_SKIP() << "cannot pin threads here";
+    }
+    EXPECT_EQ(homes[0], 0);
+    EXPECT_EQ(homes[1], 1);
+}
+#endif
+
+TEST(ShardedResourcePoolTest, TimeoutAndWakeUpWhenExhausted) {
+    ShardedResourcePool<ShardedConnection> pool(2, 2);
+    auto a = pool.acquire_handle();
+    auto b = pool.acquire_handle();
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(pool.try_acquire_handle(std::chrono::milliseconds(30)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(30));
+
+    std::thread waiter([&]() {
+        auto handle = pool.acquire_handle();  // Sleeps until b is released
+        EXPECT_TRUE(handle);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    b.reset();
+    waiter.join();
+    EXPECT_EQ(pool.current_usage(), 1);
+    // Only the timed-out call counts; probing the empty shards does not
+    EXPECT_EQ(pool.total_timeouts(), 1u);
+    EXPECT_EQ(pool.shard(0).total_timeouts(), 0u);
+    EXPECT_EQ(pool.shard(1).total_timeouts(), 0u);
+}
+
+TEST(ShardedResourcePoolTest, ExclusiveOwnershipUnderContention) {
+    ShardedResourcePool<ShardedConnection> pool(6, 3);
+    std::atomic<int> completed{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 500; ++j) {
+                ResourceGuard<ShardedConnection, ShardedResourcePool<ShardedConnection>>
+                    guard(pool);
+                ASSERT_TRUE(guard.valid());
+                EXPECT_EQ(guard->borrowers.fetch_add(1), 0);
+                guard->borrowers.fetch_sub(1);
+                completed.fetch_add(1);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(completed.load(), 4000);
+    EXPECT_EQ(pool.current_usage(), 0);
+    EXPECT_EQ(pool.available_count(), 6);
+}
+
+TEST(ShardedResourcePoolTest, RejectsEmptyPool) {
+    EXPECT_THROW(ShardedResourcePool<ShardedConnection>(0, 4), std::invalid_argument);
+}
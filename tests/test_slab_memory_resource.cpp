@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <set>
+#include <thread>
+#include <vector>
+#include "producer_consumer.hpp"
+#include "slab_memory_resource.hpp"
+#include "thread_safe_cache.hpp"
+#include "thread_safe_queue.hpp"
+
+using namespace concurrency;
+
+// Upstream that counts what it hands out
+class CountingResource : public std::pmr::memory_resource {
+public:
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> outstanding{0};
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        allocations.fetch_add(1);
+        outstanding.fetch_add(1);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        outstanding.fetch_sub(1);
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+TEST(SlabMemoryResourceTest, ReusesFreedBlocks) {
+    SlabMemoryResource slab;
+    void *a = slab.allocate(24);
+    void *b = slab.allocate(24);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % alignof(std::max_align_t), 0);
+    slab.deallocate(a, 24);
+    EXPECT_EQ(slab.allocate(20), a);  // Same 32-byte class, LIFO reuse
+    slab.deallocate(a, 20);
+    slab.deallocate(b, 24);
+    EXPECT_EQ(slab.slab_count(), 1);
+}
+
+TEST(SlabMemoryResourceTest, LargeAndOverAlignedGoUpstream) {
+    CountingResource upstream;
+    {
+        SlabMemoryResource slab(4096, 8, &upstream);
+        void *small = slab.allocate(64);
+        EXPECT_EQ(upstream.allocations.load(), 1);  // First slab
+        void *large = slab.allocate(SlabMemoryResource::kMaxBlock + 1);
+        void *aligned = slab.allocate(64, 64);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+        EXPECT_EQ(upstream.allocations.load(), 3);
+        slab.deallocate(aligned, 64, 64);
+        slab.deallocate(large, SlabMemoryResource::kMaxBlock + 1);
+        slab.deallocate(small, 64);
+        EXPECT_EQ(upstream.outstanding.load(), 1);
+    }
+    EXPECT_EQ(upstream.outstanding.load(), 0);
+}
+
+TEST(SlabMemoryResourceTest, CrossThreadAllocateAndFree) {
+    SlabMemoryResource slab(4096, 16);
+    ThreadSafeQueue<void *> handoff;
+    constexpr int kBlocks = 20000;
+
+    std::thread producer([&]() {
+        for (int i = 0; i < kBlocks; ++i) {
+            auto *p = static_cast<int *>(slab.allocate(sizeof(int) * 8));
+            p[0] = i;
+            handoff.push(p);
+        }
+    });
+    std::thread consumer([&]() {
+        std::set<int> seen;
+        for (int i = 0; i < kBlocks; ++i) {
+            auto *p = static_cast<int *>(handoff.wait_and_pop());
+            seen.insert(p[0]);
+            slab.deallocate(p, sizeof(int) * 8);
+        }
+        EXPECT_EQ(seen.size(), static_cast<size_t>(kBlocks));
+    });
+    producer.join();
+    consumer.join();
+
+    // Everything the consumer freed is back in the depot for other threads
+    size_t slabs = slab.slab_count();
+    std::thread reuser([&]() {
+        std::vector<void *> blocks;
+        for (size_t i = 0; i < slabs * slab.slab_size() / 32; ++i) {
+            blocks.push_back(slab.allocate(sizeof(int) * 8));
+        }
+        for (void *p : blocks) {
+            slab.deallocate(p, sizeof(int) * 8);
+        }
+    });
+    reuser.join();
+    EXPECT_EQ(slab.slab_count(), slabs);
+}
+
+TEST(SlabMemoryResourceTest, ThreadMayOutliveResource) {
+    std::atomic<bool> freed{false};
+    std::atomic<bool> done{false};
+    auto slab = std::make_unique<SlabMemoryResource>();
+    std::thread worker([&]() {
+        void *p = slab->allocate(32);
+        slab->deallocate(p, 32);  // Parked in this thread's cache
+        freed = true;
+        while (!done.load()) {
+            std::this_thread::yield();
+        }
+        // Exiting flushes a cache whose resource is gone
+    });
+    while (!freed.load()) {
+        std::this_thread::yield();
+    }
+    slab.reset();
+    done = true;
+    worker.join();
+}
+
+TEST(SlabMemoryResourceTest, BacksLibraryContainers) {
+    CountingResource upstream;
+    SlabMemoryResource slab(64 * 1024, 32, &upstream);
+
+    pmr::ThreadSafeQueue<int> queue(&slab);
+    for (int i = 0; i < 100; ++i) {
+        queue.push(i);
+    }
+    EXPECT_EQ(queue.try_pop(), 0);
+
+    pmr::ThreadSafeCache<int, int> cache(4, &slab);
+    for (int i = 0; i < 10; ++i) {
+        cache.put(i, i * i);
+    }
+    EXPECT_EQ(cache.size(), 4);
+    EXPECT_EQ(cache.get(9), 81);
+
+    pmr::ProducerConsumer<int> pc(8, &slab);
+    std::atomic<int> next{0};
+    pc.start(2, 2, [&]() { return next.fetch_add(1); }, [](int) {});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    pc.stop();
+    EXPECT_GT(pc.items_consumed(), 0);
+
+    EXPECT_GT(upstream.allocations.load(), 0);
+    EXPECT_EQ(upstream.allocations.load(), slab.slab_count());
+}
+
+TEST(SlabMemoryResourceTest, RejectsBadConfiguration) {
+    EXPECT_THROW(SlabMemoryResource(512), std::invalid_argument);
+    EXPECT_THROW(SlabMemoryResource(4096, 0), std::invalid_argument);
+}
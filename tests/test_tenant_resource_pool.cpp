@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "tenant_resource_pool.hpp"
+
+using namespace concurrency;
+
+struct TenantConnection {
+    int id;
+    explicit TenantConnection(int connection_id) : id(connection_id) {}
+};
+
+using Pool = TenantResourcePool<TenantConnection>;
+
+TEST(TenantResourcePoolTest, ValidatesQuotas) {
+    Pool pool(4);
+    EXPECT_THROW(pool.add_tenant(2, 1), std::invalid_argument);
+    EXPECT_THROW(pool.add_tenant(0, 0), std::invalid_argument);
+    pool.add_tenant(3, 4);
+    EXPECT_THROW(pool.add_tenant(2, 4), std::invalid_argument);  // 5 reserved
+    EXPECT_EQ(pool.shared_capacity(), 1);
+}
+
+TEST(TenantResourcePoolTest, IdleReservationsAreLentAndReclaimed) {
+    Pool pool(6);
+    auto noisy = pool.add_tenant(1, 6);
+    auto quiet = pool.add_tenant(2, 3);
+    EXPECT_EQ(pool.shared_capacity(), 3);
+
+    // Quiet is idle, so noisy may borrow its reservation too
+    std::vector<Pool::Handle> held;
+    for (int i = 0; i < 6; ++i) {
+        held.push_back(pool.try_acquire(noisy, std::chrono::milliseconds(10)));
+        ASSERT_TRUE(held.back());
+    }
+    EXPECT_EQ(pool.borrowed(noisy), 5);
+    EXPECT_EQ(pool.lent(), 2);
+
+    // Quiet wants its reservation back: the next releases go to it, and
+    // noisy cannot re-borrow them meanwhile
+    std::atomic<int> reclaimed{0};
+    std::vector<Pool::Handle> quiet_held(2);
+    std::vector<std::thread> owners;
+    for (int i = 0; i < 2; ++i) {
+        owners.emplace_back([&, i]() {
+            quiet_held[i] = pool.acquire(quiet);
+            reclaimed.fetch_add(1);
+        });
+    }
+    while (pool.owed() < 2) {
+        std::this_thread::yield();
+    }
+    held.pop_back();
+    EXPECT_FALSE(pool.try_acquire(noisy, std::chrono::milliseconds(10)));
+    held.pop_back();
+    for (auto &owner : owners) {
+        owner.join();
+    }
+    EXPECT_EQ(reclaimed.load(), 2);
+    EXPECT_EQ(pool.owed(), 0);
+    EXPECT_EQ(pool.in_use(quiet), 2);
+    EXPECT_EQ(pool.lent(), 0);
+
+    // Quiet above its reservation borrows like anyone else
+    held.pop_back();
+    auto q3 = pool.acquire(quiet);
+    EXPECT_EQ(pool.borrowed(quiet), 1);
+    EXPECT_EQ(pool.borrowed_total(), 3);
+}
+
+TEST(TenantResourcePoolTest, ReleaseWakesOnlyOneWaiter) {
+    Pool pool(1);
+    auto tenant = pool.add_tenant(0, 1);
+    auto other = pool.add_tenant(0, 1);
+    auto held = pool.acquire(tenant);
+
+    std::atomic<int> served{0};
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 4; ++i) {
+        waiters.emplace_back([&, i]() {
+            // Each waiter holds on, so the others must wait for it
+            auto handle = pool.acquire(i % 2 ? tenant : other);
+            served.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    held.reset();
+    for (auto &waiter : waiters) {
+        waiter.join();
+    }
+    EXPECT_EQ(served.load(), 4);
+    EXPECT_EQ(pool.pool().current_usage(), 0);
+}
+
+TEST(TenantResourcePoolTest, MaxQuotaCapsTenant) {
+    Pool pool(4);
+    auto tenant = pool.add_tenant(0, 2);
+    auto a = pool.acquire(tenant);
+    auto b = pool.acquire(tenant);
+    EXPECT_FALSE(pool.try_acquire(tenant, std::chrono::milliseconds(10)));
+    EXPECT_EQ(pool.pool().current_usage(), 2);
+}
+
+TEST(TenantResourcePoolTest, WaiterWokenByRelease) {
+    Pool pool(2);
+    auto tenant = pool.add_tenant(1, 1);
+    auto other = pool.add_tenant(1, 2);
+    auto held = pool.acquire(tenant);
+
+    std::atomic<bool> got{false};
+    std::thread waiter([&]() {
+        auto handle = pool.acquire(tenant);
+        got = static_cast<bool>(handle);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(got.load());
+    auto unrelated = pool.acquire(other);  // Own reservation, no wait
+    held.reset();
+    waiter.join();
+    EXPECT_TRUE(got.load());
+}
+
+TEST(TenantResourcePoolTest, QuotasHoldUnderContention) {
+    Pool pool(8);
+    std::vector<Pool::TenantId> tenants = {pool.add_tenant(2, 8),
+                                           pool.add_tenant(2, 4),
+                                           pool.add_tenant(1, 3)};
+    std::atomic<bool> violated{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 9; ++i) {
+        threads.emplace_back([&, i]() {
+            auto tenant = tenants[i % tenants.size()];
+            for (int j = 0; j < 500; ++j) {
+                auto handle = pool.acquire(tenant);
+                if (!handle || pool.in_use(tenant) > pool.max(tenant) ||
+                    pool.pool().current_usage() > pool.pool().size()) {
+                    violated = true;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_FALSE(violated.load());
+    for (auto tenant : tenants) {
+        EXPECT_EQ(pool.in_use(tenant), 0);
+    }
+    EXPECT_EQ(pool.borrowed_total(), 0);
+    EXPECT_EQ(pool.owed(), 0);
+    EXPECT_EQ(pool.pool().current_usage(), 0);
+}